@@ -0,0 +1,217 @@
+/**
+ * @file libsrcslice.cpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <new>
+#include <srcslice.h>
+#include <srcslicedispatcher.hpp>
+
+//Flattened view of a SliceProfile so sets can be handed out as contiguous arrays
+struct srcslice_profile{
+    const SliceProfile* profile;
+    std::vector<unsigned int> definitions;
+    std::vector<unsigned int> uses;
+    std::vector<const char*> dvars;
+    std::vector<const char*> aliases;
+};
+
+struct srcslice_archive{
+    std::unordered_map<std::string, std::vector<SliceProfile>> profileMap;
+    std::vector<srcslice_profile> profiles;
+    std::string errorMessage;
+};
+
+namespace {
+    //Rebuild the handles after every parse; profileMap may have rehashed or merged entries
+    void RebuildProfiles(srcslice_archive* archive){
+        archive->profiles.clear();
+        for(auto& entry : archive->profileMap){
+            for(auto& profile : entry.second){
+                srcslice_profile flat;
+                flat.profile = &profile;
+                flat.definitions.assign(profile.definitions.begin(), profile.definitions.end());
+                flat.uses.assign(profile.uses.begin(), profile.uses.end());
+#if SRCSLICE_ENABLE_DVARS
+                for(const std::string& dvar : profile.dvars){
+                    flat.dvars.push_back(dvar.c_str());
+                }
+#endif
+#if SRCSLICE_ENABLE_ALIASES
+                for(const std::string& alias : profile.aliases){
+                    flat.aliases.push_back(alias.c_str());
+                }
+#endif
+                archive->profiles.push_back(std::move(flat));
+            }
+        }
+    }
+
+    template<typename Source>
+    int Parse(srcslice_archive* archive, Source source){
+        archive->errorMessage.clear();
+        try{
+            SrcSlicePolicy policy(&archive->profileMap);
+            srcSAXController control(source);
+            SrcSliceEventDispatcher<> handler({&policy});
+            control.parse(&handler);
+        }catch(std::exception& e){
+            archive->errorMessage = e.what();
+        }catch(...){
+            archive->errorMessage = "unknown error while parsing srcML";
+        }
+        RebuildProfiles(archive);
+        return archive->errorMessage.empty() ? SRCSLICE_STATUS_OK : SRCSLICE_STATUS_ERROR;
+    }
+}
+
+extern "C" {
+
+srcslice_archive* srcslice_create(void){
+    return new (std::nothrow) srcslice_archive();
+}
+
+void srcslice_free(srcslice_archive* archive){
+    delete archive;
+}
+
+void srcslice_clear(srcslice_archive* archive){
+    if(!archive) return;
+    archive->profiles.clear();
+    archive->profileMap.clear();
+    archive->errorMessage.clear();
+}
+
+int srcslice_parse_memory(srcslice_archive* archive, const char* buffer, size_t size){
+    if(!archive || !buffer) return SRCSLICE_STATUS_INVALID_ARGUMENT;
+    return Parse(archive, std::string(buffer, size));
+}
+
+int srcslice_parse_filename(srcslice_archive* archive, const char* filename){
+    if(!archive || !filename) return SRCSLICE_STATUS_INVALID_ARGUMENT;
+    return Parse(archive, filename);
+}
+
+const char* srcslice_error_message(const srcslice_archive* archive){
+    return archive ? archive->errorMessage.c_str() : "";
+}
+
+size_t srcslice_profile_count(const srcslice_archive* archive){
+    return archive ? archive->profiles.size() : 0;
+}
+
+const srcslice_profile* srcslice_get_profile(const srcslice_archive* archive, size_t index){
+    if(!archive || index >= archive->profiles.size()) return 0;
+    return &archive->profiles[index];
+}
+
+const char* srcslice_profile_name(const srcslice_profile* profile){
+    return profile ? profile->profile->variableName.c_str() : 0;
+}
+
+const char* srcslice_profile_type(const srcslice_profile* profile){
+    return profile ? profile->profile->variableType.c_str() : 0;
+}
+
+const char* srcslice_profile_file(const srcslice_profile* profile){
+    return profile ? profile->profile->file.c_str() : 0;
+}
+
+const char* srcslice_profile_containing_class(const srcslice_profile* profile){
+#if SRCSLICE_ENABLE_CONTAINING_CLASS
+    return profile ? profile->profile->nameOfContainingClass.c_str() : 0;
+#else
+    return profile ? "" : 0;
+#endif
+}
+
+int srcslice_profile_line(const srcslice_profile* profile){
+    return profile ? profile->profile->lineNumber : 0;
+}
+
+int srcslice_profile_contains_declaration(const srcslice_profile* profile){
+    return profile ? profile->profile->containsDeclaration : 0;
+}
+
+int srcslice_profile_is_global(const srcslice_profile* profile){
+    return profile ? profile->profile->isGlobal : 0;
+}
+
+int srcslice_profile_is_potential_alias(const srcslice_profile* profile){
+    return profile ? profile->profile->potentialAlias : 0;
+}
+
+size_t srcslice_profile_definitions(const srcslice_profile* profile, const unsigned int** lines){
+    if(!profile) return 0;
+    if(lines) *lines = profile->definitions.data();
+    return profile->definitions.size();
+}
+
+size_t srcslice_profile_uses(const srcslice_profile* profile, const unsigned int** lines){
+    if(!profile) return 0;
+    if(lines) *lines = profile->uses.data();
+    return profile->uses.size();
+}
+
+size_t srcslice_profile_dvar_count(const srcslice_profile* profile){
+    return profile ? profile->dvars.size() : 0;
+}
+
+const char* srcslice_profile_dvar(const srcslice_profile* profile, size_t index){
+    if(!profile || index >= profile->dvars.size()) return 0;
+    return profile->dvars[index];
+}
+
+size_t srcslice_profile_alias_count(const srcslice_profile* profile){
+    return profile ? profile->aliases.size() : 0;
+}
+
+const char* srcslice_profile_alias(const srcslice_profile* profile, size_t index){
+    if(!profile || index >= profile->aliases.size()) return 0;
+    return profile->aliases[index];
+}
+
+#if SRCSLICE_ENABLE_CFUNCTIONS
+size_t srcslice_profile_cfunction_count(const srcslice_profile* profile){
+    return profile ? profile->profile->cfunctions.size() : 0;
+}
+
+const char* srcslice_profile_cfunction_name(const srcslice_profile* profile, size_t index){
+    if(!profile || index >= profile->profile->cfunctions.size()) return 0;
+    return profile->profile->cfunctions[index].first.c_str();
+}
+
+const char* srcslice_profile_cfunction_arguments(const srcslice_profile* profile, size_t index){
+    if(!profile || index >= profile->profile->cfunctions.size()) return 0;
+    return profile->profile->cfunctions[index].second.c_str();
+}
+#else
+//Compiled without call tracking; no profile records any calls
+size_t srcslice_profile_cfunction_count(const srcslice_profile*){
+    return 0;
+}
+
+const char* srcslice_profile_cfunction_name(const srcslice_profile*, size_t){
+    return 0;
+}
+
+const char* srcslice_profile_cfunction_arguments(const srcslice_profile*, size_t){
+    return 0;
+}
+#endif
+
+}
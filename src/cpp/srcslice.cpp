@@ -1,18 +1,187 @@
-#include <srcslicepolicy.hpp>
+#include <srcsliceparallel.hpp>
+#include <srcslicepipeline.hpp>
+#include <slicesource.hpp>
+#include <changeimpact.hpp>
+#include <srcslicewatch.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
 int main(int argc, char** argv){
-        if(argc < 2){
-            std::cerr<<"Syntax: ./srcslice [srcML file name]"<<std::endl;
+        const char* srcmlFile = 0;
+        ChangeImpact changeImpact;
+        std::vector<std::string> lineQueries;
+        bool printDefUseChains = false;
+        unsigned int numThreads = 1;
+        bool printSource = false;
+        bool pipeline = false;
+        std::string sourceRoot;
+        std::string watchRoot;
+        for(int i = 1; i < argc; ++i){
+            if(std::strcmp(argv[i], "--changed") == 0 && i + 1 < argc){
+                if(!changeImpact.AddRange(argv[++i])){
+                    std::cerr<<"Invalid change range: "<<argv[i]<<" (expected file:line or file:start-end)"<<std::endl;
+                    return 1;
+                }
+            }else if(std::strcmp(argv[i], "--line") == 0 && i + 1 < argc){
+                std::string file;
+                unsigned int start, end;
+                if(!ParseLineRange(argv[++i], file, start, end)){
+                    std::cerr<<"Invalid line: "<<argv[i]<<" (expected file:line or file:start-end)"<<std::endl;
+                    return 1;
+                }
+                lineQueries.push_back(argv[i]);
+            }else if(std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc){
+                numThreads = std::max(1, std::atoi(argv[++i]));
+            }else if(std::strcmp(argv[i], "--pipeline") == 0){
+                pipeline = true;
+            }else if(std::strcmp(argv[i], "--source") == 0){
+                printSource = true;
+            }else if(std::strcmp(argv[i], "--source-root") == 0 && i + 1 < argc){
+                printSource = true;
+                sourceRoot = argv[++i];
+            }else if(std::strcmp(argv[i], "--watch") == 0 && i + 1 < argc){
+                watchRoot = argv[++i];
+            }else if(std::strcmp(argv[i], "--def-use") == 0){
+                printDefUseChains = true;
+            }else{
+                srcmlFile = argv[i];
+            }
+        }
+        if(!srcmlFile){
+            std::cerr<<"Syntax: ./srcslice [--changed file:start-end]... [--line file:line]... [--def-use] [--threads N | --pipeline] [--source] [--source-root dir] [--watch source dir] [srcML file name]"<<std::endl;
             return 0;
         }
         std::unordered_map<std::string, std::vector<SliceProfile>> profileMap;
+        SliceSourceExtractor sourceExtractor(sourceRoot);
+        LineIndex lineIndex;
+        //the index --source checks lines against, once the slicer records into it
+        const LineIndex* recordedLines = 0;
+        auto printProfile = [&](SliceProfile& profile){
+            profile.PrintProfile();
+            if(!printSource) return;
+            for(const auto& line : sourceExtractor.Extract(profile, recordedLines)){
+                std::cout<<line.first<<": ";
+                std::cout.write(line.second.data, line.second.size);
+                std::cout<<std::endl;
+            }
+        };
+        if(!watchRoot.empty()){
+            if(!changeImpact.Empty() || !lineQueries.empty() || printDefUseChains){
+                std::cerr<<"--watch cannot be combined with --changed, --line or --def-use"<<std::endl;
+                return 1;
+            }
+#ifdef __linux__
+            std::ifstream input(srcmlFile);
+            std::stringstream buffer;
+            buffer<<input.rdbuf();
+            //Keep every unit resident and re-slice only the files that are saved
+            ProfileStore store;
+            std::size_t numUnits = store.Load(buffer.str(), numThreads);
+            std::cerr<<"Watching "<<watchRoot<<" ("<<numUnits<<" units loaded)"<<std::endl;
+            WatchAndReslice(store, watchRoot, [&](const std::string& file, const ProfileStore::ProfileMap* profiles){
+                std::cout<<(profiles ? "UPDATED: " : "REMOVED: ")<<file<<std::endl;
+                if(!profiles) return;
+                for(auto it : *profiles){
+                    for(auto profile : it.second){
+                        if(profile.containsDeclaration)
+                            printProfile(profile);
+                    }
+                }
+                std::cout.flush();
+            });
+            std::cerr<<"Cannot watch "<<watchRoot<<std::endl;
+            return 1;
+#else
+            std::cerr<<"--watch requires inotify and is only available on Linux"<<std::endl;
+            return 1;
+#endif
+        }
+        if(numThreads > 1){
+            //regions record no line index, so --source could not tell a global's lines in other files apart
+            if(!changeImpact.Empty() || !lineQueries.empty() || printDefUseChains || pipeline || printSource){
+                std::cerr<<"--threads cannot be combined with --changed, --line, --def-use, --pipeline or --source"<<std::endl;
+                return 1;
+            }
+            std::ifstream input(srcmlFile);
+            std::stringstream buffer;
+            buffer<<input.rdbuf();
+            std::string srcml = buffer.str();
+            //Several regions per thread so one heavy region does not leave the others idle
+            std::size_t regionSize = std::max<std::size_t>(srcml.size() / (numThreads * 4), 64 * 1024);
+            ParallelSlice(SrcMLRegionSplitter(srcml).Split(regionSize), profileMap, numThreads);
+            for(auto it : profileMap){
+                for(auto profile : it.second){
+                    if(profile.containsDeclaration)
+                        printProfile(profile);
+                }
+            }
+            return 0;
+        }
         SrcSlicePolicy* cat = new SrcSlicePolicy(&profileMap);
-        srcSAXController control(argv[1]);
-        srcSAXEventDispatch::srcSAXEventDispatcher<> handler({cat});
-        control.parse(&handler); //Start parsing
+        if(!lineQueries.empty() || printSource) cat->SetLineIndex(&lineIndex);
+        if(printSource) recordedLines = &lineIndex;
+        if(!changeImpact.Empty()) cat->SetChangeImpact(&changeImpact);
+        cat->EnableDefUseChains(printDefUseChains);
+        srcSAXController control(srcmlFile);
+        SrcSliceEventDispatcher<> handler({cat});
+        //Start parsing; --pipeline parses on a second thread while this one slices
+        if(pipeline)
+            PipelinedParse(control, handler);
+        else
+            control.parse(&handler);
+        lineIndex.Seal();
+        if(printDefUseChains){
+            for(const DefUseChain& chain : cat->DefUseChains()){
+                std::cout<<chain.variableName<<": "<<chain.definitionLine<<" -> "<<chain.useLine<<std::endl;
+            }
+            return 0;
+        }
+        if(!changeImpact.Empty()){
+            //Only report what the changed definitions can reach
+            for(const SliceProfile* affected : changeImpact.ForwardSlice(profileMap)){
+                SliceProfile profile = *affected;
+                printProfile(profile);
+            }
+            return 0;
+        }
+        if(!lineQueries.empty()){
+            //The declared profile behind every name defined or used on the queried lines
+            for(const std::string& query : lineQueries){
+                std::string file;
+                unsigned int start, end;
+                ParseLineRange(query, file, start, end);
+                auto holdsLine = [&](const SliceProfile& profile){
+                    auto definition = profile.definitions.lower_bound(start);
+                    auto use = profile.uses.lower_bound(start);
+                    return (definition != profile.definitions.end() && *definition <= end) ||
+                           (use != profile.uses.end() && *use <= end);
+                };
+                std::cout<<query<<":"<<std::endl;
+                for(const std::string& name : lineIndex.Query(file, start, end)){
+                    auto it = profileMap.find(name);
+                    if(it == profileMap.end()) continue;
+                    std::vector<SliceProfile*> matches;
+                    for(SliceProfile& profile : it->second){
+                        if(profile.containsDeclaration && SamePath(profile.file, file) && holdsLine(profile)) matches.push_back(&profile);
+                    }
+                    //a global used here was merged into its declaration in another file
+                    if(matches.empty()){
+                        for(SliceProfile& profile : it->second){
+                            if(profile.containsDeclaration && holdsLine(profile)) matches.push_back(&profile);
+                        }
+                    }
+                    for(SliceProfile* profile : matches){
+                        printProfile(*profile);
+                    }
+                }
+            }
+            return 0;
+        }
         for(auto it : profileMap){
             for(auto profile : it.second){
             	if(profile.containsDeclaration)
-                	profile.PrintProfile();
+                	printProfile(profile);
             }
         }
-}
\ No newline at end of file
+}
@@ -0,0 +1,44 @@
+/**
+ * @file GatedPolicy.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <srcSAXEventDispatcher.hpp>
+#ifndef GATEDPOLICY
+#define GATEDPOLICY
+/*
+ * Wraps a policy so it can stay registered with the dispatcher for the whole parse.
+ * Events only reach the wrapped policy while its trigger element is open: from the
+ * outermost trigger's open event up to and including the matching close event.
+ * This replaces adding and removing the policy around every trigger element.
+ */
+template <typename Policy>
+class GatedPolicy : public Policy {
+    public:
+        GatedPolicy(srcSAXEventDispatch::ParserState trigger) : trigger(trigger), depth(0){}
+        void HandleEvent(srcSAXEventDispatch::ParserState pstate, srcSAXEventDispatch::ElementState estate, srcSAXEventDispatch::srcSAXEventContext& ctx) override {
+            bool isTrigger = pstate == trigger;
+            if(isTrigger && estate == srcSAXEventDispatch::ElementState::open) ++depth;
+            if(!depth) return;
+            Policy::HandleEvent(pstate, estate, ctx);
+            if(isTrigger && estate == srcSAXEventDispatch::ElementState::close) --depth;
+        }
+    private:
+        srcSAXEventDispatch::ParserState trigger;
+        unsigned int depth;
+};
+#endif
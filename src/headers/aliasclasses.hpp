@@ -0,0 +1,276 @@
+/**
+ * @file aliasclasses.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <cstddef>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#ifndef ALIASCLASSES
+#define ALIASCLASSES
+/*
+ * Alias equivalence classes kept in a union-find with path compression and union by
+ * rank. Every declaration is a member of its own, so pointers named p in two functions
+ * never share a class; a name resolves to its latest member, the declaration in scope
+ * while slicing. Every class also keeps one member per distinct name, the smaller list
+ * merged into the larger on union, so its names are listed in time linear in their count.
+ */
+class AliasClasses{
+    public:
+        //A new member for a declaration of name; name resolves to it from now on
+        unsigned int Add(const std::string& name){
+            unsigned int id = names.size();
+            names.push_back(name);
+            nameOf.push_back(NameId(name));
+            parent.push_back(id);
+            rank.push_back(0);
+            latest[name] = id;
+            return id;
+        }
+        //The member name resolves to, added if name has no member yet
+        unsigned int Latest(const std::string& name){
+            auto found = latest.find(name);
+            return found == latest.end() ? Add(name) : found->second;
+        }
+        //Copies in every member and class of other; returns the offset added to other's ids
+        unsigned int Import(const AliasClasses& other){
+            unsigned int offset = names.size();
+            std::vector<unsigned int> nameIdOf(other.nameIds.size());
+            for(const auto& entry : other.nameIds){
+                nameIdOf[entry.second] = NameId(entry.first);
+            }
+            for(unsigned int id = 0; id < other.names.size(); ++id){
+                names.push_back(other.names[id]);
+                nameOf.push_back(nameIdOf[other.nameOf[id]]);
+                parent.push_back(other.parent[id] + offset);
+                rank.push_back(other.rank[id]);
+            }
+            for(const auto& entry : other.classMembers){
+                ClassMembers& imported = classMembers[entry.first + offset];
+                for(unsigned int id : entry.second.distinct){
+                    imported.distinct.push_back(id + offset);
+                    imported.nameIds.insert(nameIdOf[other.nameOf[id]]);
+                }
+            }
+            for(const auto& entry : other.latest){
+                latest[entry.first] = entry.second + offset;
+            }
+            return offset;
+        }
+        unsigned int Find(unsigned int id) const{
+            unsigned int root = id;
+            while(parent[root] != root) root = parent[root];
+            while(parent[id] != root){
+                unsigned int up = parent[id];
+                parent[id] = root;
+                id = up;
+            }
+            return root;
+        }
+        void Union(unsigned int lhs, unsigned int rhs){
+            unsigned int lhsRoot = Find(lhs), rhsRoot = Find(rhs);
+            if(lhsRoot == rhsRoot) return;
+            if(rank[lhsRoot] < rank[rhsRoot]) std::swap(lhsRoot, rhsRoot);
+            parent[rhsRoot] = lhsRoot;
+            if(rank[lhsRoot] == rank[rhsRoot]) ++rank[lhsRoot];
+            ClassMembers merged = TakeMembers(lhsRoot), smaller = TakeMembers(rhsRoot);
+            if(merged.distinct.size() < smaller.distinct.size()) std::swap(merged, smaller);
+            for(unsigned int id : smaller.distinct){
+                if(merged.nameIds.insert(nameOf[id]).second) merged.distinct.push_back(id);
+            }
+            classMembers[lhsRoot] = std::move(merged);
+        }
+        bool SameClass(unsigned int lhs, unsigned int rhs) const{
+            return Find(lhs) == Find(rhs);
+        }
+        //One member per distinct name in id's class, or null if id is alone in it
+        const std::vector<unsigned int>* Members(unsigned int id) const{
+            auto found = classMembers.find(Find(id));
+            return found == classMembers.end() ? 0 : &found->second.distinct;
+        }
+        //Whether some member of id's class is named name
+        bool HasName(unsigned int id, const std::string& name) const{
+            auto nameId = nameIds.find(name);
+            if(nameId == nameIds.end()) return false;
+            if(nameId->second == nameOf[id]) return true;
+            auto found = classMembers.find(Find(id));
+            return found != classMembers.end() && found->second.nameIds.count(nameId->second);
+        }
+        bool SameName(unsigned int lhs, unsigned int rhs) const{
+            return nameOf[lhs] == nameOf[rhs];
+        }
+        const std::string& Name(unsigned int id) const{
+            return names[id];
+        }
+    private:
+        //Kept for roots of classes with more than one member
+        struct ClassMembers{
+            std::vector<unsigned int> distinct;
+            std::unordered_set<unsigned int> nameIds;
+        };
+
+        //deque so references handed out by Name stay valid as members are added
+        std::deque<std::string> names;
+        std::unordered_map<std::string, unsigned int> latest;
+        std::unordered_map<std::string, unsigned int> nameIds;
+        std::vector<unsigned int> nameOf;
+        mutable std::vector<unsigned int> parent;
+        std::vector<unsigned int> rank;
+        std::unordered_map<unsigned int, ClassMembers> classMembers;
+
+        unsigned int NameId(const std::string& name){
+            return nameIds.insert(std::make_pair(name, (unsigned int)nameIds.size())).first->second;
+        }
+        ClassMembers TakeMembers(unsigned int root){
+            ClassMembers members;
+            auto found = classMembers.find(root);
+            if(found == classMembers.end()){
+                members.distinct.push_back(root);
+                members.nameIds.insert(nameOf[root]);
+                return members;
+            }
+            members = std::move(found->second);
+            classMembers.erase(found);
+            return members;
+        }
+};
+
+/*
+ * The aliases of one profile: the names of the other members of its declaration's
+ * alias class, each listed once and never the profile's own name. Offers the subset
+ * of the std::set interface SliceProfile::aliases was used with.
+ */
+class AliasSet{
+    public:
+        class const_iterator{
+            public:
+                typedef std::forward_iterator_tag iterator_category;
+                typedef const std::string value_type;
+                typedef std::ptrdiff_t difference_type;
+                typedef const std::string* pointer;
+                typedef const std::string& reference;
+
+                const_iterator() : classes(0), members(0), owner(0), index(0){}
+                //Starts at the first member not named like owner
+                const_iterator(const AliasClasses* classes, unsigned int owner) : classes(classes), members(classes->Members(owner)), owner(owner), index(0){
+                    SkipOwnerName();
+                }
+                const std::string& operator*() const{
+                    return classes->Name((*members)[index]);
+                }
+                const std::string* operator->() const{
+                    return &classes->Name((*members)[index]);
+                }
+                const_iterator& operator++(){
+                    ++index;
+                    SkipOwnerName();
+                    return *this;
+                }
+                const_iterator operator++(int){
+                    const_iterator previous = *this;
+                    ++*this;
+                    return previous;
+                }
+                bool operator==(const const_iterator& other) const{
+                    return members == other.members && (!members || index == other.index);
+                }
+                bool operator!=(const const_iterator& other) const{
+                    return !(*this == other);
+                }
+            private:
+                const AliasClasses* classes;
+                const std::vector<unsigned int>* members;
+                unsigned int owner;
+                std::size_t index;
+
+                //The class lists each name once, the owner's among them; the end is a null list
+                void SkipOwnerName(){
+                    if(!members) return;
+                    if(index < members->size() && classes->SameName((*members)[index], owner)) ++index;
+                    if(index == members->size()) members = 0;
+                }
+        };
+
+        AliasSet(std::string owner = "") : ownerName(owner), owner(0){}
+
+        //Join a shared set of classes as a new member for the owner's declaration
+        void Attach(std::shared_ptr<AliasClasses> aliasClasses, const std::string& name){
+            classes = aliasClasses;
+            ownerName = name;
+            owner = classes->Add(ownerName);
+        }
+        //Move to classes that imported this set's classes at offset (see AliasClasses::Import)
+        void Rebind(std::shared_ptr<AliasClasses> aliasClasses, unsigned int offset){
+            classes = aliasClasses;
+            owner += offset;
+        }
+        std::shared_ptr<AliasClasses> Classes() const{
+            return classes;
+        }
+        //Alias the declaration name currently resolves to
+        void insert(const std::string& name){
+            if(!classes) Attach(std::make_shared<AliasClasses>(), ownerName);
+            classes->Union(owner, classes->Latest(name));
+        }
+        template <typename Iterator>
+        void insert(Iterator first, Iterator last){
+            for(; first != last; ++first) insert(*first);
+        }
+        //Take on other's aliases, as when folding another profile of the same variable into this one
+        void Join(const AliasSet& other){
+            if(!other.classes) return;
+            if(!classes) Attach(other.classes, ownerName);
+            if(classes == other.classes){
+                classes->Union(owner, other.owner);
+                return;
+            }
+            insert(other.begin(), other.end());
+        }
+        const_iterator find(const std::string& name) const{
+            if(!classes || name == ownerName || !classes->HasName(owner, name)) return end();
+            for(const_iterator alias = begin(); alias != end(); ++alias){
+                if(*alias == name) return alias;
+            }
+            return end();
+        }
+        const_iterator begin() const{
+            if(!classes || !classes->Members(owner)) return end();
+            return const_iterator(classes.get(), owner);
+        }
+        const_iterator end() const{
+            return const_iterator();
+        }
+        //Every name in the class but the owner's
+        std::size_t size() const{
+            const std::vector<unsigned int>* members = classes ? classes->Members(owner) : 0;
+            return members ? members->size() - 1 : 0;
+        }
+        bool empty() const{
+            return size() == 0;
+        }
+    private:
+        std::shared_ptr<AliasClasses> classes;
+        std::string ownerName;
+        unsigned int owner;
+};
+#endif
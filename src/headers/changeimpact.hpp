@@ -0,0 +1,166 @@
+/**
+ * @file changeimpact.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <srcsliceconfig.hpp>
+#include <lineindex.hpp>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#ifndef CHANGEIMPACT
+#define CHANGEIMPACT
+/*
+ * Restricts slicing output to the forward impact of a set of changed lines.
+ * The slicer offers every definition it sees and only those on changed lines
+ * are kept, in a LineIndex of their own, so the index grows with the diff
+ * rather than with the archive.
+ */
+class ChangeImpact{
+    public:
+        //Accepts "file:line" or "file:start-end"; returns false if the spec is malformed
+        bool AddRange(const std::string& spec){
+            std::string file;
+            unsigned int start, end;
+            if(!ParseLineRange(spec, file, start, end)) return false;
+            changedLines[NormalizePath(file)].push_back(std::make_pair(start, end));
+            lastFile.clear();
+            lastRanges = 0;
+            return true;
+        }
+        bool Empty() const{
+            return changedLines.empty();
+        }
+        bool Contains(const std::string& file, unsigned int line) const{
+            auto ranges = FindRanges(file);
+            if(!ranges) return false;
+            for(auto range : *ranges){
+                if(line >= range.first && line <= range.second) return true;
+            }
+            return false;
+        }
+        //Keeps the definition if it is on a changed line
+        void RecordDefinition(const std::string& file, unsigned int line, const std::string& name){
+            if(Contains(file, line)) changedDefinitions.Record(file, line, name, LineIndex::DEFINITION);
+        }
+        //Names defined on a changed line
+        std::unordered_set<std::string> ChangedDefinitions(){
+            changedDefinitions.Seal();
+            std::unordered_set<std::string> changed;
+            for(const auto& file : changedLines){
+                for(auto range : file.second){
+                    for(std::string& name : changedDefinitions.Query(file.first, range.first, range.second)){
+                        changed.insert(std::move(name));
+                    }
+                }
+            }
+            return changed;
+        }
+        /*
+         * Profiles reachable from the definitions on changed lines through dvars and aliases.
+         * Seeds are the profiles whose file and definitions hold a changed line, not every
+         * profile of the name; a global assigned in one file was merged into its declaration
+         * in another, so failing that the declared profile holding the line is the seed.
+         * Names carry no scope, so a dependence is only followed to profiles of the same
+         * file; crossing files would pull in every like-named variable.
+         */
+        template<typename ProfileMap>
+        std::vector<const typename ProfileMap::mapped_type::value_type*> ForwardSlice(const ProfileMap& profileMap){
+            changedDefinitions.Seal();
+            typedef typename ProfileMap::mapped_type::value_type Profile;
+            std::vector<const Profile*> affected;
+            std::unordered_set<const Profile*> seen;
+            auto visit = [&](const Profile& profile){
+                if(seen.insert(&profile).second) affected.push_back(&profile);
+            };
+            for(const auto& file : changedLines){
+                for(auto range : file.second){
+                    for(const std::string& name : changedDefinitions.Query(file.first, range.first, range.second)){
+                        auto profiles = profileMap.find(name);
+                        if(profiles == profileMap.end()) continue;
+                        auto holdsLine = [&](const Profile& profile){
+                            auto definition = profile.definitions.lower_bound(range.first);
+                            return definition != profile.definitions.end() && *definition <= range.second;
+                        };
+                        bool seeded = false;
+                        for(const Profile& profile : profiles->second){
+                            if(SamePath(profile.file, file.first) && holdsLine(profile)){
+                                visit(profile);
+                                seeded = true;
+                            }
+                        }
+                        if(seeded) continue;
+                        for(const Profile& profile : profiles->second){
+                            if(profile.containsDeclaration && holdsLine(profile)) visit(profile);
+                        }
+                    }
+                }
+            }
+            auto follow = [&](const Profile& from, const std::string& name){
+                auto profiles = profileMap.find(name);
+                if(profiles == profileMap.end()) return;
+                for(const Profile& profile : profiles->second){
+                    if(profile.file == from.file) visit(profile);
+                }
+            };
+            //affected doubles as the worklist
+            for(std::size_t next = 0; next < affected.size(); ++next){
+                const Profile& profile = *affected[next];
+#if SRCSLICE_ENABLE_DVARS
+                for(const std::string& dvar : profile.dvars){
+                    follow(profile, dvar);
+                }
+#endif
+#if SRCSLICE_ENABLE_ALIASES
+                for(const std::string& alias : profile.aliases){
+                    follow(profile, alias);
+                }
+#endif
+#if !SRCSLICE_ENABLE_DVARS && !SRCSLICE_ENABLE_ALIASES
+                (void)follow;
+                (void)profile;
+#endif
+            }
+            return affected;
+        }
+    private:
+        typedef std::vector<std::pair<unsigned int, unsigned int>> RangeList;
+        std::unordered_map<std::string, RangeList> changedLines;
+        LineIndex changedDefinitions;
+
+        //Lookups tend to repeat the same file, so the last match is cached
+        mutable std::string lastFile;
+        mutable const RangeList* lastRanges = 0;
+
+        //Fall back to suffix matching; see SamePath
+        const RangeList* FindRanges(const std::string& file) const{
+            if(file == lastFile) return lastRanges;
+            lastFile = file;
+            lastRanges = MatchRanges(NormalizePath(file));
+            return lastRanges;
+        }
+        const RangeList* MatchRanges(const std::string& normalized) const{
+            auto exact = changedLines.find(normalized);
+            if(exact != changedLines.end()) return &exact->second;
+            for(const auto& entry : changedLines){
+                if(SamePath(entry.first, normalized)) return &entry.second;
+            }
+            return 0;
+        }
+};
+#endif
@@ -0,0 +1,197 @@
+/**
+ * @file lineindex.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#ifndef LINEINDEX
+#define LINEINDEX
+//Parses "file:line" or "file:start-end"; returns false if the spec is malformed
+inline bool ParseLineRange(const std::string& spec, std::string& file, unsigned int& start, unsigned int& end){
+    std::size_t colon = spec.rfind(':');
+    if(colon == std::string::npos || colon == 0 || colon + 1 == spec.size()) return false;
+    std::string lines = spec.substr(colon + 1);
+    std::size_t dash = lines.find('-');
+    try{
+        start = std::stoul(lines.substr(0, dash));
+        end = dash == std::string::npos ? start : std::stoul(lines.substr(dash + 1));
+    }catch(std::exception&){
+        return false;
+    }
+    if(end < start) return false;
+    file = spec.substr(0, colon);
+    return true;
+}
+
+//Where path starts once leading "./" components are dropped
+inline std::size_t NormalizedStart(const std::string& path){
+    std::size_t start = 0;
+    while(path.compare(start, 2, "./") == 0) start += 2;
+    return start;
+}
+
+inline std::string NormalizePath(const std::string& path){
+    return path.substr(NormalizedStart(path));
+}
+
+//Diff paths and srcML unit filenames often differ by a leading directory, so one may be a path suffix of the other
+inline bool SamePath(const std::string& lhs, const std::string& rhs){
+    std::size_t lhsLength = lhs.size() - NormalizedStart(lhs), rhsLength = rhs.size() - NormalizedStart(rhs);
+    bool lhsShorter = lhsLength <= rhsLength;
+    const std::string& shorter = lhsShorter ? lhs : rhs;
+    const std::string& longer = lhsShorter ? rhs : lhs;
+    std::size_t length = lhsShorter ? lhsLength : rhsLength;
+    std::size_t longerLength = lhsShorter ? rhsLength : lhsLength;
+    if(longer.compare(longer.size() - length, length, shorter, shorter.size() - length, length) != 0) return false;
+    return length == longerLength || longer[longer.size() - length - 1] == '/';
+}
+
+/*
+ * Reverse index from (file, line) to the names defined or used there. Records are
+ * appended while slicing and folded by Seal into one sorted key array with a flat
+ * posting list per key, so a query is a binary search plus a contiguous scan.
+ * Records made after the last Seal are not visible to queries until the next one.
+ */
+class LineIndex{
+    public:
+        enum Kind : std::uint8_t { DEFINITION = 1, USE = 2, ANY = DEFINITION | USE };
+
+        void Record(const std::string& file, unsigned int line, const std::string& name, Kind kind){
+            pending.push_back(Entry{FileId(file), line, NameId(name), kind});
+        }
+        //Fold pending records into the sorted layout
+        void Seal(){
+            if(pending.empty()) return;
+            for(std::size_t key = 0; key < keys.size(); ++key){
+                for(std::uint32_t posting = offsets[key]; posting < offsets[key + 1]; ++posting){
+                    pending.push_back(Entry{keys[key].file, keys[key].line, postings[posting].name, postings[posting].kinds});
+                }
+            }
+            std::sort(pending.begin(), pending.end());
+            keys.clear();
+            offsets.clear();
+            postings.clear();
+            for(const Entry& entry : pending){
+                if(keys.empty() || keys.back().file != entry.file || keys.back().line != entry.line){
+                    keys.push_back(Key{entry.file, entry.line});
+                    offsets.push_back(postings.size());
+                }else if(postings.back().name == entry.name){
+                    postings.back().kinds |= entry.kinds;
+                    continue;
+                }
+                postings.push_back(Posting{entry.name, entry.kinds});
+            }
+            offsets.push_back(postings.size());
+            pending.clear();
+            pending.shrink_to_fit();
+        }
+        //Names with a record of one of kinds on a line in [first, last] of file, sorted and unique
+        std::vector<std::string> Query(const std::string& file, unsigned int first, unsigned int last, Kind kinds = ANY) const{
+            std::vector<std::uint32_t> found;
+            for(std::uint32_t fileId : MatchFiles(file)){
+                auto key = std::lower_bound(keys.begin(), keys.end(), Key{fileId, first});
+                for(; key != keys.end() && key->file == fileId && key->line <= last; ++key){
+                    std::size_t index = key - keys.begin();
+                    for(std::uint32_t posting = offsets[index]; posting < offsets[index + 1]; ++posting){
+                        if(postings[posting].kinds & kinds) found.push_back(postings[posting].name);
+                    }
+                }
+            }
+            std::vector<std::string> result;
+            for(std::uint32_t name : found){
+                result.push_back(names[name]);
+            }
+            std::sort(result.begin(), result.end());
+            result.erase(std::unique(result.begin(), result.end()), result.end());
+            return result;
+        }
+        std::vector<std::string> Query(const std::string& file, unsigned int line, Kind kinds = ANY) const{
+            return Query(file, line, line, kinds);
+        }
+        std::size_t NumLines() const{
+            return keys.size();
+        }
+    private:
+        struct Key{
+            std::uint32_t file, line;
+            bool operator<(const Key& other) const{
+                return file != other.file ? file < other.file : line < other.line;
+            }
+        };
+        struct Posting{
+            std::uint32_t name;
+            std::uint8_t kinds;
+        };
+        struct Entry{
+            std::uint32_t file, line, name;
+            std::uint8_t kinds;
+            bool operator<(const Entry& other) const{
+                if(file != other.file) return file < other.file;
+                if(line != other.line) return line < other.line;
+                return name < other.name;
+            }
+        };
+
+        std::vector<Key> keys;
+        //postings of keys[i] are postings[offsets[i]] up to postings[offsets[i + 1]]
+        std::vector<std::uint32_t> offsets;
+        std::vector<Posting> postings;
+        std::vector<Entry> pending;
+
+        std::vector<std::string> files;
+        std::unordered_map<std::string, std::uint32_t> fileIds;
+        //the same file may have been recorded under several spellings
+        std::unordered_map<std::string, std::vector<std::uint32_t>> normalizedFileIds;
+        std::vector<std::string> names;
+        std::unordered_map<std::string, std::uint32_t> nameIds;
+        //Records arrive unit by unit, so the last file is almost always the next one
+        std::string lastFile;
+        std::uint32_t lastFileId = 0;
+
+        std::uint32_t FileId(const std::string& file){
+            if(!files.empty() && file == lastFile) return lastFileId;
+            auto inserted = fileIds.insert(std::make_pair(file, (std::uint32_t)files.size()));
+            if(inserted.second){
+                files.push_back(file);
+                normalizedFileIds[NormalizePath(file)].push_back(inserted.first->second);
+            }
+            lastFile = file;
+            lastFileId = inserted.first->second;
+            return lastFileId;
+        }
+        //Files recorded under file's normalized path; only if there are none, files it is a path suffix of or vice versa
+        std::vector<std::uint32_t> MatchFiles(const std::string& file) const{
+            auto exact = normalizedFileIds.find(NormalizePath(file));
+            if(exact != normalizedFileIds.end()) return exact->second;
+            std::vector<std::uint32_t> matches;
+            for(std::uint32_t fileId = 0; fileId < files.size(); ++fileId){
+                if(SamePath(file, files[fileId])) matches.push_back(fileId);
+            }
+            return matches;
+        }
+        std::uint32_t NameId(const std::string& name){
+            auto inserted = nameIds.insert(std::make_pair(name, (std::uint32_t)names.size()));
+            if(inserted.second) names.push_back(name);
+            return inserted.first->second;
+        }
+};
+#endif
@@ -0,0 +1,219 @@
+/**
+ * @file profilestore.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <srcsliceparallel.hpp>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#ifndef PROFILESTORE
+#define PROFILESTORE
+/*
+ * Resident slice profiles kept per unit. Every unit is sliced on its own, so replacing
+ * one file retracts exactly the profiles it contributed and slices only its new srcML;
+ * the other units are never touched. Lookups by name go through a name -> units index
+ * kept up to date by the same retract/apply steps. A unit's uses of a global declared
+ * in another unit stay in its own profiles, so Unit differs from a batch run there;
+ * Merged folds them into the declaration again each time it is asked for.
+ */
+class ProfileStore{
+    public:
+        typedef std::unordered_map<std::string, std::vector<SliceProfile>> ProfileMap;
+
+        /*
+         * Slice every unit of a srcML document; returns the number of units loaded. Units
+         * are keyed by filename; one without a filename is keyed "<unit N>" by its position
+         * and a filename repeated in the document gets "#2", "#3"... so no unit replaces
+         * another from the same document.
+         */
+        std::size_t Load(const std::string& srcml, unsigned int numThreads = 1){
+            std::vector<std::pair<std::string, std::string>> regions = SrcMLRegionSplitter(srcml).SplitUnits();
+            std::vector<ProfileMap> unitProfiles(regions.size());
+            std::atomic<std::size_t> nextUnit(0);
+
+            xmlInitParser();
+            auto worker = [&](){
+                for(std::size_t unit = nextUnit++; unit < regions.size(); unit = nextUnit++){
+                    unitProfiles[unit] = Slice(regions[unit].second);
+                }
+            };
+            std::vector<std::thread> threads;
+            for(unsigned int i = 1; i < std::max(numThreads, 1u); ++i){
+                threads.push_back(std::thread(worker));
+            }
+            worker();
+            for(std::thread& thread : threads){
+                thread.join();
+            }
+
+            std::unordered_map<std::string, unsigned int> timesSeen;
+            for(std::size_t unit = 0; unit < regions.size(); ++unit){
+                const std::string& filename = regions[unit].first;
+                std::string key = filename.empty() ? "<unit " + std::to_string(unit + 1) + ">" : filename;
+                unsigned int seen = ++timesSeen[key];
+                if(seen > 1) key += "#" + std::to_string(seen);
+                Retract(key);
+                Apply(key, filename, std::move(unitProfiles[unit]));
+            }
+            return regions.size();
+        }
+        //Swap file's profiles for those sliced from srcml, a single unit or an archive holding it
+        void Replace(const std::string& file, const std::string& srcml){
+            ProfileMap profiles = Slice(srcml);
+            Retract(file);
+            Apply(file, file, std::move(profiles));
+        }
+        void Remove(const std::string& file){
+            Retract(file);
+        }
+        //Profiles contributed by file, or null if it is not in the store
+        const ProfileMap* Unit(const std::string& file) const{
+            auto unit = units.find(file);
+            return unit == units.end() ? 0 : &unit->second;
+        }
+        /*
+         * file's profiles as a batch run over every unit reports them: a name first declared
+         * here, in load order, takes in the undeclared profiles of that name from the other
+         * units. Profiles of other units are left as they are.
+         */
+        ProfileMap Merged(const std::string& file) const{
+            auto unit = units.find(file);
+            if(unit == units.end()) return ProfileMap();
+            ProfileMap merged = unit->second;
+#if SRCSLICE_ENABLE_ALIASES
+            //joining aliases while merging must leave the stored classes alone
+            std::unordered_map<const AliasClasses*, std::shared_ptr<AliasClasses>> copies;
+            for(auto& entry : merged){
+                for(SliceProfile& profile : entry.second){
+                    std::shared_ptr<AliasClasses> classes = profile.aliases.Classes();
+                    if(!classes) continue;
+                    std::shared_ptr<AliasClasses>& copy = copies[classes.get()];
+                    if(!copy) copy = std::make_shared<AliasClasses>(*classes);
+                    profile.aliases.Rebind(copy, 0);
+                }
+            }
+#endif
+            for(auto& entry : merged){
+                if(!Declares(entry.second) || FirstDeclaringUnit(entry.first) != file) continue;
+                for(const std::string& other : unitsOfName.at(entry.first)){
+                    if(other == file) continue;
+                    for(const SliceProfile& profile : units.at(other).at(entry.first)){
+                        if(!profile.containsDeclaration) entry.second.push_back(profile);
+                    }
+                }
+            }
+            //every unit was merged when it was sliced, so only the names extended above change
+            SrcSlicePolicy::MergeProfiles(merged);
+            return merged;
+        }
+        //Units whose merged profiles take in file's uses of globals declared elsewhere
+        std::unordered_set<std::string> DeclaringUnits(const std::string& file) const{
+            std::unordered_set<std::string> declaring;
+            auto unit = units.find(file);
+            if(unit == units.end()) return declaring;
+            for(const auto& entry : unit->second){
+                if(Declares(entry.second)) continue;
+                std::string first = FirstDeclaringUnit(entry.first);
+                if(!first.empty()) declaring.insert(first);
+            }
+            return declaring;
+        }
+        //Every profile of name across all units
+        std::vector<const SliceProfile*> Profiles(const std::string& name) const{
+            std::vector<const SliceProfile*> profiles;
+            auto containing = unitsOfName.find(name);
+            if(containing == unitsOfName.end()) return profiles;
+            for(const std::string& file : containing->second){
+                for(const SliceProfile& profile : units.at(file).at(name)){
+                    profiles.push_back(&profile);
+                }
+            }
+            return profiles;
+        }
+        //Key of the unit stored for path, matching by path suffix as well; empty if none
+        std::string FindUnit(const std::string& path) const{
+            if(units.count(path)) return path;
+            for(const auto& unit : units){
+                if(SamePath(unit.first, path)) return unit.first;
+            }
+            return "";
+        }
+        std::size_t NumUnits() const{
+            return units.size();
+        }
+    private:
+        std::unordered_map<std::string, ProfileMap> units;
+        std::unordered_map<std::string, std::unordered_set<std::string>> unitsOfName;
+        //position each key was first loaded at; a replaced unit keeps its place, as in the archive
+        std::unordered_map<std::string, std::size_t> loadOrder;
+
+        static bool Declares(const std::vector<SliceProfile>& profiles){
+            return std::any_of(profiles.begin(), profiles.end(),
+                [](const SliceProfile& profile){ return profile.containsDeclaration; });
+        }
+        //The unit whose declaration of name a batch run folds the other units' uses into
+        std::string FirstDeclaringUnit(const std::string& name) const{
+            std::string first;
+            auto containing = unitsOfName.find(name);
+            if(containing == unitsOfName.end()) return first;
+            for(const std::string& file : containing->second){
+                if(!Declares(units.at(file).at(name))) continue;
+                if(first.empty() || loadOrder.at(file) < loadOrder.at(first)) first = file;
+            }
+            return first;
+        }
+
+        static ProfileMap Slice(const std::string& srcml){
+            ProfileMap profiles;
+            SrcSlicePolicy policy(&profiles);
+            srcSAXController control(srcml);
+            SrcSliceEventDispatcher<> handler({&policy});
+            control.parse(&handler);
+            //a lone unit has no archive to close, so merge here as well
+            SrcSlicePolicy::MergeProfiles(profiles);
+            return profiles;
+        }
+        void Retract(const std::string& file){
+            auto unit = units.find(file);
+            if(unit == units.end()) return;
+            for(const auto& entry : unit->second){
+                auto containing = unitsOfName.find(entry.first);
+                if(containing == unitsOfName.end()) continue;
+                containing->second.erase(file);
+                if(containing->second.empty()) unitsOfName.erase(containing);
+            }
+            units.erase(unit);
+        }
+        //Profiles carry path however srcML spelled it; key differs from path only for a disambiguated unit
+        void Apply(const std::string& key, const std::string& path, ProfileMap profiles){
+            for(auto& entry : profiles){
+                unitsOfName[entry.first].insert(key);
+                for(SliceProfile& profile : entry.second){
+                    profile.file = path;
+                }
+            }
+            units[key] = std::move(profiles);
+            loadOrder.insert(std::make_pair(key, loadOrder.size()));
+        }
+};
+#endif
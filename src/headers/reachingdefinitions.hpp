@@ -0,0 +1,332 @@
+/**
+ * @file reachingdefinitions.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#ifndef REACHINGDEFINITIONS
+#define REACHINGDEFINITIONS
+/*
+ * Dense bit set used for the dataflow sets. The loops run a whole 64-bit word
+ * at a time over plain arrays so the compiler can vectorize them at -O3.
+ */
+class BitVector{
+    public:
+        BitVector(std::size_t numBits = 0) : words((numBits + 63) / 64, 0){}
+        void Set(std::size_t bit){
+            words[bit / 64] |= (std::uint64_t(1) << (bit % 64));
+        }
+        void Reset(std::size_t bit){
+            words[bit / 64] &= ~(std::uint64_t(1) << (bit % 64));
+        }
+        bool Test(std::size_t bit) const{
+            return (words[bit / 64] >> (bit % 64)) & 1;
+        }
+        void Clear(){
+            std::fill(words.begin(), words.end(), 0);
+        }
+        void UnionWith(const BitVector& other){
+            std::uint64_t* __restrict dst = words.data();
+            const std::uint64_t* __restrict src = other.words.data();
+            for(std::size_t i = 0, n = words.size(); i < n; ++i){
+                dst[i] |= src[i];
+            }
+        }
+        void IntersectWith(const BitVector& other){
+            std::uint64_t* __restrict dst = words.data();
+            const std::uint64_t* __restrict src = other.words.data();
+            for(std::size_t i = 0, n = words.size(); i < n; ++i){
+                dst[i] &= src[i];
+            }
+        }
+        void Subtract(const BitVector& other){
+            std::uint64_t* __restrict dst = words.data();
+            const std::uint64_t* __restrict src = other.words.data();
+            for(std::size_t i = 0, n = words.size(); i < n; ++i){
+                dst[i] &= ~src[i];
+            }
+        }
+        std::size_t NumWords() const{
+            return words.size();
+        }
+        bool operator==(const BitVector& other) const{
+            return words == other.words;
+        }
+        bool operator!=(const BitVector& other) const{
+            return words != other.words;
+        }
+    private:
+        std::vector<std::uint64_t> words;
+};
+
+struct DefUseChain{
+    DefUseChain(std::string name, unsigned int def, unsigned int use) : variableName(name), definitionLine(def), useLine(use){}
+    std::string variableName;
+    unsigned int definitionLine;
+    unsigned int useLine;
+};
+
+/*
+ * Per-function reaching definitions. Statements are appended in source order while
+ * Begin/End calls mark the structured control flow around them: every arm of a branch
+ * starts from the branch entry and the branch exits through any arm, or past them all
+ * unless one is an else; a loop repeats through an empty header node and exits from its
+ * condition, which a do tests after the body. Break, continue and return are not
+ * modelled, and every switch case may also be reached by falling through, so the
+ * skeleton only ever adds paths and the chains over-approximate rather than miss a pair.
+ */
+class ReachingDefinitions{
+    public:
+        typedef std::vector<std::pair<std::string, unsigned int>> NameLineList;
+
+        void BeginFunction(){
+            nodes.clear();
+            regions.clear();
+            hasClosedBranch = false;
+            variableIds.clear();
+            definitionsOfVariable.clear();
+            definitions.clear();
+            frontier.clear();
+            //node 0 is the function entry where parameters are defined
+            nodes.push_back(Node());
+            frontier.push_back(0);
+        }
+        void AddParameter(const std::string& name, unsigned int line){
+            AddDefinition(0, name, line);
+        }
+        //Uses are read before the statement's definitions take effect
+        void AddStatement(const NameLineList& defs, const NameLineList& uses){
+            if(defs.empty() && uses.empty()) return;
+            unsigned int node = AddNode();
+            for(const auto& use : uses){
+                nodes[node].uses.push_back(std::make_pair(VariableId(use.first), use.second));
+            }
+            for(const auto& def : defs){
+                AddDefinition(node, def.first, def.second);
+            }
+        }
+        void BeginBranch(){
+            regions.push_back(Region(frontier, nodes.size(), false));
+            hasClosedBranch = false;
+        }
+        void BeginLoop(){
+            regions.push_back(Region(frontier, nodes.size(), true));
+            AddNode();
+            hasClosedBranch = false;
+        }
+        //Starts the next arm of the innermost branch from its entry; a switch case can also be reached by falling through
+        void NextArm(bool fallthrough = false){
+            if(regions.empty() || regions.back().isLoop) return;
+            Region& region = regions.back();
+            region.armExits.insert(region.armExits.end(), frontier.begin(), frontier.end());
+            if(fallthrough){
+                frontier.insert(frontier.end(), region.entryFrontier.begin(), region.entryFrontier.end());
+                Deduplicate(frontier);
+            }else{
+                //an else arm: some arm always runs
+                frontier = region.entryFrontier;
+                region.skippable = false;
+            }
+        }
+        //Moves the innermost region's entry to the current point, past a condition or a for init
+        void MarkRegionEntry(){
+            if(regions.empty()) return;
+            regions.back().entryFrontier = frontier;
+            regions.back().firstNode = nodes.size();
+            if(regions.back().isLoop) AddNode();
+        }
+        //The innermost loop leaves from the current point, right after its condition
+        void MarkLoopExit(){
+            if(regions.empty() || !regions.back().isLoop) return;
+            regions.back().armExits = frontier;
+        }
+        /*
+         * Reopens the branch closed last as long as nothing was added after it, for an else
+         * that the srcML places next to its if rather than inside it. Returns false if there
+         * is no such branch.
+         */
+        bool ReopenBranch(){
+            if(!hasClosedBranch || closedBranchEnd != nodes.size()) return false;
+            hasClosedBranch = false;
+            closedBranch.skippable = false;
+            frontier = closedBranch.entryFrontier;
+            regions.push_back(closedBranch);
+            return true;
+        }
+        void EndRegion(){
+            if(regions.empty()) return;
+            Region region = regions.back();
+            regions.pop_back();
+            if(region.isLoop){
+                //back to the header, which has the entry as well, so zero iterations are covered
+                for(unsigned int pred : frontier){
+                    nodes[region.firstNode].predecessors.push_back(pred);
+                }
+                Deduplicate(nodes[region.firstNode].predecessors);
+                frontier = region.armExits.empty() ? std::vector<unsigned int>(1, region.firstNode) : region.armExits;
+                hasClosedBranch = false;
+                return;
+            }
+            region.armExits.insert(region.armExits.end(), frontier.begin(), frontier.end());
+            Deduplicate(region.armExits);
+            frontier = region.armExits;
+            //the body may not execute at all
+            if(region.skippable){
+                frontier.insert(frontier.end(), region.entryFrontier.begin(), region.entryFrontier.end());
+                Deduplicate(frontier);
+            }
+            //armExits now holds every arm's exit, ready for ReopenBranch
+            hasClosedBranch = true;
+            closedBranch = region;
+            closedBranchEnd = nodes.size();
+        }
+        std::vector<DefUseChain> EndFunction(){
+            std::vector<DefUseChain> chains;
+            std::size_t numDefinitions = definitions.size();
+            if(numDefinitions == 0) return chains;
+
+            //Only OUT is kept per node; IN is rebuilt from the predecessors when needed
+            std::vector<BitVector> out(nodes.size(), BitVector(numDefinitions));
+            BitVector in(numDefinitions), next(numDefinitions);
+            std::vector<BitVector> killMasks = BuildKillMasks(numDefinitions);
+
+            //Nodes are in source order, so forward passes converge in roughly loop-depth iterations
+            bool changed = true;
+            while(changed){
+                changed = false;
+                for(std::size_t node = 0; node < nodes.size(); ++node){
+                    next.Clear();
+                    for(unsigned int pred : nodes[node].predecessors){
+                        next.UnionWith(out[pred]);
+                    }
+                    for(unsigned int def : nodes[node].definitions){
+                        Kill(next, definitions[def].variable, killMasks);
+                    }
+                    for(unsigned int def : nodes[node].definitions){
+                        next.Set(def);
+                    }
+                    if(next != out[node]){
+                        std::swap(out[node], next);
+                        changed = true;
+                    }
+                }
+            }
+
+            std::vector<std::string> variableNames(variableIds.size());
+            for(const auto& variable : variableIds){
+                variableNames[variable.second] = variable.first;
+            }
+            for(std::size_t node = 0; node < nodes.size(); ++node){
+                if(nodes[node].uses.empty()) continue;
+                in.Clear();
+                for(unsigned int pred : nodes[node].predecessors){
+                    in.UnionWith(out[pred]);
+                }
+                for(const auto& use : nodes[node].uses){
+                    if(use.first >= definitionsOfVariable.size()) continue;
+                    for(unsigned int def : definitionsOfVariable[use.first]){
+                        if(in.Test(def)){
+                            chains.push_back(DefUseChain(variableNames[use.first], definitions[def].line, use.second));
+                        }
+                    }
+                }
+            }
+            return chains;
+        }
+    private:
+        struct Definition{
+            unsigned int variable;
+            unsigned int line;
+        };
+        struct Node{
+            std::vector<unsigned int> predecessors;
+            std::vector<unsigned int> definitions;
+            std::vector<std::pair<unsigned int, unsigned int>> uses;
+        };
+        struct Region{
+            Region(const std::vector<unsigned int>& entry = {}, unsigned int first = 0, bool loop = false) : entryFrontier(entry), firstNode(first), isLoop(loop), skippable(true){}
+            std::vector<unsigned int> entryFrontier;
+            //where the arms finished so far leave off, or where a loop leaves from
+            std::vector<unsigned int> armExits;
+            unsigned int firstNode;
+            bool isLoop;
+            bool skippable;
+        };
+
+        std::vector<Node> nodes;
+        std::vector<Region> regions;
+        std::vector<unsigned int> frontier;
+        Region closedBranch;
+        std::size_t closedBranchEnd = 0;
+        bool hasClosedBranch = false;
+        std::unordered_map<std::string, unsigned int> variableIds;
+        std::vector<std::vector<unsigned int>> definitionsOfVariable;
+        std::vector<Definition> definitions;
+
+        //Appends a node after the current point; an empty one only joins paths
+        unsigned int AddNode(){
+            unsigned int node = nodes.size();
+            nodes.push_back(Node());
+            nodes[node].predecessors = frontier;
+            frontier.assign(1, node);
+            return node;
+        }
+        static void Deduplicate(std::vector<unsigned int>& ids){
+            std::sort(ids.begin(), ids.end());
+            ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+        }
+        unsigned int VariableId(const std::string& name){
+            auto inserted = variableIds.insert(std::make_pair(name, (unsigned int)variableIds.size()));
+            return inserted.first->second;
+        }
+        //Variables with more definitions than the set has words get a dense kill mask; the rest are reset bit by bit
+        std::vector<BitVector> BuildKillMasks(std::size_t numDefinitions) const{
+            std::vector<BitVector> killMasks(definitionsOfVariable.size());
+            std::size_t numWords = BitVector(numDefinitions).NumWords();
+            for(std::size_t variable = 0; variable < definitionsOfVariable.size(); ++variable){
+                if(definitionsOfVariable[variable].size() <= numWords) continue;
+                killMasks[variable] = BitVector(numDefinitions);
+                for(unsigned int def : definitionsOfVariable[variable]){
+                    killMasks[variable].Set(def);
+                }
+            }
+            return killMasks;
+        }
+        void Kill(BitVector& set, unsigned int variable, const std::vector<BitVector>& killMasks) const{
+            if(killMasks[variable].NumWords()){
+                set.Subtract(killMasks[variable]);
+                return;
+            }
+            for(unsigned int def : definitionsOfVariable[variable]){
+                set.Reset(def);
+            }
+        }
+        void AddDefinition(unsigned int node, const std::string& name, unsigned int line){
+            unsigned int variable = VariableId(name);
+            if(definitionsOfVariable.size() <= variable) definitionsOfVariable.resize(variable + 1);
+            unsigned int def = definitions.size();
+            definitions.push_back(Definition{variable, line});
+            definitionsOfVariable[variable].push_back(def);
+            nodes[node].definitions.push_back(def);
+        }
+};
+#endif
@@ -0,0 +1,182 @@
+/**
+ * @file slicesource.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <srcslicepolicy.hpp>
+#include <lineindex.hpp>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#include <sstream>
+#endif
+#ifndef SLICESOURCE
+#define SLICESOURCE
+//Zero-copy view of one source line inside a MappedSource; not null terminated
+struct SourceLine{
+    const char* data;
+    std::size_t size;
+    std::string str() const{
+        return std::string(data, size);
+    }
+};
+
+/*
+ * Read-only memory mapping of a source file plus the offset of every line start,
+ * computed once when the file is opened. Without POSIX mmap the file is read into
+ * memory instead.
+ */
+class MappedSource{
+    public:
+#if defined(__unix__) || defined(__APPLE__)
+        MappedSource(const std::string& path) : data(0), size(0){
+            int fd = open(path.c_str(), O_RDONLY);
+            if(fd < 0) return;
+            struct stat info;
+            if(fstat(fd, &info) == 0){
+                opened = true;
+                //mmap rejects empty files; they simply have no lines
+                if(info.st_size > 0){
+                    void* mapping = mmap(0, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                    if(mapping != MAP_FAILED){
+                        data = static_cast<const char*>(mapping);
+                        size = info.st_size;
+                    }else{
+                        opened = false;
+                    }
+                }
+            }
+            close(fd);
+            BuildLineTable();
+        }
+        ~MappedSource(){
+            if(data) munmap(const_cast<char*>(data), size);
+        }
+#else
+        MappedSource(const std::string& path) : data(0), size(0){
+            std::ifstream input(path, std::ios::binary);
+            if(!input) return;
+            std::stringstream buffer;
+            buffer<<input.rdbuf();
+            contents = buffer.str();
+            opened = true;
+            if(!contents.empty()){
+                data = contents.data();
+                size = contents.size();
+            }
+            BuildLineTable();
+        }
+#endif
+        MappedSource(const MappedSource&) = delete;
+        MappedSource& operator=(const MappedSource&) = delete;
+
+        bool IsOpen() const{
+            return opened;
+        }
+        std::size_t NumLines() const{
+            return lineOffsets.size();
+        }
+        //lineNumber is 1-based, matching SliceProfile line numbers; out of range lines are empty
+        SourceLine Line(unsigned int lineNumber) const{
+            if(lineNumber == 0 || lineNumber > lineOffsets.size()) return SourceLine{data, 0};
+            std::size_t begin = lineOffsets[lineNumber - 1];
+            std::size_t end = lineNumber < lineOffsets.size() ? lineOffsets[lineNumber] - 1 : size;
+            //the last line keeps its terminator when the file ends with one
+            if(lineNumber == lineOffsets.size() && end > begin && data[end - 1] == '\n') --end;
+            if(end > begin && data[end - 1] == '\r') --end;
+            return SourceLine{data + begin, end - begin};
+        }
+    private:
+        const char* data;
+        std::size_t size;
+        bool opened = false;
+        std::vector<std::size_t> lineOffsets;
+#if !defined(__unix__) && !defined(__APPLE__)
+        std::string contents;
+#endif
+
+        void BuildLineTable(){
+            if(!data) return;
+            lineOffsets.push_back(0);
+            const char* current = data;
+            const char* end = data + size;
+            while(const char* newline = static_cast<const char*>(std::memchr(current, '\n', end - current))){
+                current = newline + 1;
+                if(current == end) break;
+                lineOffsets.push_back(current - data);
+            }
+        }
+};
+
+/*
+ * Renders the source text of slice profiles. Every file named by a profile is mapped
+ * once and kept for the lifetime of the extractor, so rendering many profiles from the
+ * same file never re-reads or re-splits it.
+ */
+class SliceSourceExtractor{
+    public:
+        SliceSourceExtractor(std::string sourceRoot = "") : sourceRoot(sourceRoot){
+            if(!this->sourceRoot.empty() && this->sourceRoot.back() != '/') this->sourceRoot += '/';
+        }
+        //Returns null if the file cannot be opened
+        const MappedSource* Source(const std::string& file){
+            auto cached = sources.find(file);
+            if(cached == sources.end()){
+                std::string path = (!file.empty() && file[0] == '/') ? file : sourceRoot + file;
+                std::unique_ptr<MappedSource> source(new MappedSource(path));
+                if(!source->IsOpen()) source.reset();
+                cached = sources.insert(std::make_pair(file, std::move(source))).first;
+            }
+            return cached->second.get();
+        }
+        /*
+         * Every definition and use line of the profile, in line order. A global's profile
+         * also holds the lines of its uses in other files, folded in from there; given the
+         * sealed index the slicer recorded into, only lines recorded under the profile's
+         * name in its own file are kept, so other files' line numbers never show this
+         * file's text.
+         */
+        std::vector<std::pair<unsigned int, SourceLine>> Extract(const SliceProfile& profile, const LineIndex* recorded = 0){
+            std::vector<std::pair<unsigned int, SourceLine>> lines;
+            const MappedSource* source = Source(profile.file);
+            if(!source) return lines;
+            std::set<unsigned int> sliceLines(profile.definitions.begin(), profile.definitions.end());
+            sliceLines.insert(profile.uses.begin(), profile.uses.end());
+            for(unsigned int line : sliceLines){
+                if(recorded){
+                    std::vector<std::string> names = recorded->Query(profile.file, line);
+                    if(!std::binary_search(names.begin(), names.end(), profile.variableName)) continue;
+                }
+                lines.push_back(std::make_pair(line, source->Line(line)));
+            }
+            return lines;
+        }
+    private:
+        std::string sourceRoot;
+        std::unordered_map<std::string, std::unique_ptr<MappedSource>> sources;
+};
+#endif
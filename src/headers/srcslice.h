@@ -0,0 +1,82 @@
+/**
+ * @file srcslice.h
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * C interface to libsrcslice. A srcslice_archive owns the slice profiles
+ * produced by every buffer or file parsed into it; profiles are read back
+ * through opaque handles that stay valid until the next parse, clear or free.
+ */
+#ifndef SRCSLICE_H
+#define SRCSLICE_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* status codes returned by the parse functions */
+#define SRCSLICE_STATUS_OK               0
+#define SRCSLICE_STATUS_ERROR            1
+#define SRCSLICE_STATUS_INVALID_ARGUMENT 2
+
+typedef struct srcslice_archive srcslice_archive;
+typedef struct srcslice_profile srcslice_profile;
+
+/* archive lifetime */
+srcslice_archive* srcslice_create(void);
+void srcslice_free(srcslice_archive* archive);
+void srcslice_clear(srcslice_archive* archive);
+
+/* slicing; results accumulate across calls until srcslice_clear */
+int srcslice_parse_memory(srcslice_archive* archive, const char* buffer, size_t size);
+int srcslice_parse_filename(srcslice_archive* archive, const char* filename);
+const char* srcslice_error_message(const srcslice_archive* archive);
+
+/* profile iteration */
+size_t srcslice_profile_count(const srcslice_archive* archive);
+const srcslice_profile* srcslice_get_profile(const srcslice_archive* archive, size_t index);
+
+/* profile fields */
+const char* srcslice_profile_name(const srcslice_profile* profile);
+const char* srcslice_profile_type(const srcslice_profile* profile);
+const char* srcslice_profile_file(const srcslice_profile* profile);
+const char* srcslice_profile_containing_class(const srcslice_profile* profile);
+int srcslice_profile_line(const srcslice_profile* profile);
+int srcslice_profile_contains_declaration(const srcslice_profile* profile);
+int srcslice_profile_is_global(const srcslice_profile* profile);
+int srcslice_profile_is_potential_alias(const srcslice_profile* profile);
+
+size_t srcslice_profile_definitions(const srcslice_profile* profile, const unsigned int** lines);
+size_t srcslice_profile_uses(const srcslice_profile* profile, const unsigned int** lines);
+
+size_t srcslice_profile_dvar_count(const srcslice_profile* profile);
+const char* srcslice_profile_dvar(const srcslice_profile* profile, size_t index);
+
+size_t srcslice_profile_alias_count(const srcslice_profile* profile);
+const char* srcslice_profile_alias(const srcslice_profile* profile, size_t index);
+
+size_t srcslice_profile_cfunction_count(const srcslice_profile* profile);
+const char* srcslice_profile_cfunction_name(const srcslice_profile* profile, size_t index);
+const char* srcslice_profile_cfunction_arguments(const srcslice_profile* profile, size_t index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
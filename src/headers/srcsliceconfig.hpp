@@ -0,0 +1,53 @@
+/**
+ * @file srcsliceconfig.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Build-time selection of the analyses SrcSlicePolicy performs. Each feature
+ * defaults to on; defining it to 0 removes its SliceProfile fields, its code
+ * paths and, where it has one, its sub-policy. Definitions and uses are always
+ * computed.
+ */
+#ifndef SRCSLICECONFIG
+#define SRCSLICECONFIG
+
+//SliceProfile::dvars -- variables whose value depends on this one
+#ifndef SRCSLICE_ENABLE_DVARS
+#define SRCSLICE_ENABLE_DVARS 1
+#endif
+
+//SliceProfile::aliases -- pointer and reference alias classes
+#ifndef SRCSLICE_ENABLE_ALIASES
+#define SRCSLICE_ENABLE_ALIASES 1
+#endif
+
+//SliceProfile::cfunctions -- calls this variable is passed to; attaches CallPolicy
+#ifndef SRCSLICE_ENABLE_CFUNCTIONS
+#define SRCSLICE_ENABLE_CFUNCTIONS 1
+#endif
+
+//Parameter declarations as definitions; attaches ParamTypePolicy
+#ifndef SRCSLICE_ENABLE_PARAMETERS
+#define SRCSLICE_ENABLE_PARAMETERS 1
+#endif
+
+//SliceProfile::nameOfContainingClass
+#ifndef SRCSLICE_ENABLE_CONTAINING_CLASS
+#define SRCSLICE_ENABLE_CONTAINING_CLASS 1
+#endif
+
+#endif
@@ -0,0 +1,80 @@
+/**
+ * @file srcslicedispatcher.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <srcslicepolicy.hpp>
+#ifndef SRCSLICEDISPATCHER
+#define SRCSLICEDISPATCHER
+/*
+ * Tracks whether the parse is inside a subtree SrcSlicePolicy::IsIgnoredElement rejects,
+ * so every handler that filters callbacks drops exactly the same ones.
+ */
+class IgnoredSubtreeFilter{
+    public:
+        //True if this element is dropped, either ignored itself or inside an ignored one
+        bool SkipStart(const char * localname, const char * prefix, int num_attributes, const struct srcsax_attribute * attributes){
+            if(depth){
+                ++depth;
+                return true;
+            }
+            if(SrcSlicePolicy::IsIgnoredElement(localname, prefix, num_attributes, attributes)){
+                depth = 1;
+                return true;
+            }
+            return false;
+        }
+        //True if the element ending here was dropped
+        bool SkipEnd(){
+            if(!depth) return false;
+            --depth;
+            return true;
+        }
+        bool Skipping() const{
+            return depth != 0;
+        }
+    private:
+        unsigned int depth = 0;
+};
+
+/*
+ * Event dispatcher that drops every subtree SrcSlicePolicy::IsIgnoredElement rejects
+ * before the base dispatcher builds tokens or updates its parser state for it.
+ */
+template <typename... policies>
+class SrcSliceEventDispatcher : public srcSAXEventDispatch::srcSAXEventDispatcher<policies...>{
+    public:
+        using srcSAXEventDispatch::srcSAXEventDispatcher<policies...>::srcSAXEventDispatcher;
+
+        void startElement(const char * localname, const char * prefix, const char * URI,
+                          int num_namespaces, const struct srcsax_namespace * namespaces, int num_attributes,
+                          const struct srcsax_attribute * attributes) override {
+            if(ignored.SkipStart(localname, prefix, num_attributes, attributes)) return;
+            srcSAXEventDispatch::srcSAXEventDispatcher<policies...>::startElement(localname, prefix, URI, num_namespaces, namespaces, num_attributes, attributes);
+        }
+        void endElement(const char * localname, const char * prefix, const char * URI) override {
+            if(ignored.SkipEnd()) return;
+            srcSAXEventDispatch::srcSAXEventDispatcher<policies...>::endElement(localname, prefix, URI);
+        }
+        void charactersUnit(const char * ch, int len) override {
+            if(ignored.Skipping()) return;
+            srcSAXEventDispatch::srcSAXEventDispatcher<policies...>::charactersUnit(ch, len);
+        }
+    private:
+        IgnoredSubtreeFilter ignored;
+};
+#endif
\ No newline at end of file
@@ -0,0 +1,327 @@
+/**
+ * @file srcsliceparallel.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <srcslicedispatcher.hpp>
+#include <libxml/parser.h>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#ifndef SRCSLICEPARALLEL
+#define SRCSLICEPARALLEL
+//Replaces the predefined entities and character references in an XML attribute value
+inline std::string XmlUnescape(const std::string& escaped){
+    std::string text;
+    text.reserve(escaped.size());
+    for(std::size_t pos = 0; pos < escaped.size(); ++pos){
+        std::size_t semicolon = escaped[pos] == '&' ? escaped.find(';', pos) : std::string::npos;
+        if(semicolon == std::string::npos){
+            text += escaped[pos];
+            continue;
+        }
+        std::string entity = escaped.substr(pos + 1, semicolon - pos - 1);
+        unsigned long code = 0;
+        if(entity == "amp") code = '&';
+        else if(entity == "lt") code = '<';
+        else if(entity == "gt") code = '>';
+        else if(entity == "quot") code = '"';
+        else if(entity == "apos") code = '\'';
+        else if(entity.size() > 1 && entity[0] == '#'){
+            bool hex = entity[1] == 'x' || entity[1] == 'X';
+            code = std::strtoul(entity.c_str() + (hex ? 2 : 1), 0, hex ? 16 : 10);
+        }
+        if(code == 0 || code > 0x10FFFF){
+            text += escaped[pos];
+            continue;
+        }
+        //UTF-8, as libxml2 hands the same value to the SAX callbacks
+        if(code < 0x80){
+            text += (char)code;
+        }else if(code < 0x800){
+            text += (char)(0xC0 | (code >> 6));
+            text += (char)(0x80 | (code & 0x3F));
+        }else if(code < 0x10000){
+            text += (char)(0xE0 | (code >> 12));
+            text += (char)(0x80 | ((code >> 6) & 0x3F));
+            text += (char)(0x80 | (code & 0x3F));
+        }else{
+            text += (char)(0xF0 | (code >> 18));
+            text += (char)(0x80 | ((code >> 12) & 0x3F));
+            text += (char)(0x80 | ((code >> 6) & 0x3F));
+            text += (char)(0x80 | (code & 0x3F));
+        }
+        pos = semicolon;
+    }
+    return text;
+}
+
+/*
+ * Splits a srcML document into standalone srcML regions. Units are cut only between
+ * their top-level children (functions, classes, namespaces, global declarations), so
+ * every function body and class keeps its full context inside one region. Each region
+ * is padded with the newlines that preceded it in its unit so line numbers stay intact.
+ */
+class SrcMLRegionSplitter{
+    public:
+        SrcMLRegionSplitter(const std::string& srcml) : srcml(srcml), isArchive(false), rootStart(0), rootTagEnd(0){
+            Scan();
+        }
+        //Regions hold roughly regionSize bytes of unit content; small neighbouring units share a region
+        std::vector<std::string> Split(std::size_t regionSize) const{
+            std::vector<std::string> regions;
+            std::vector<Piece> pieces;
+            std::size_t pendingSize = 0;
+            for(const Unit& unit : units){
+                std::size_t start = unit.contentBegin;
+                std::size_t newlines = 0;
+                for(std::size_t boundary : unit.boundaries){
+                    if(boundary - start < regionSize) continue;
+                    pieces.push_back(Piece{&unit, start, boundary, newlines});
+                    newlines += std::count(srcml.begin() + start, srcml.begin() + boundary, '\n');
+                    regions.push_back(BuildRegion(pieces));
+                    pieces.clear();
+                    pendingSize = 0;
+                    start = boundary;
+                }
+                pieces.push_back(Piece{&unit, start, unit.contentEnd, newlines});
+                pendingSize += unit.contentEnd - start;
+                if(pendingSize >= regionSize){
+                    regions.push_back(BuildRegion(pieces));
+                    pieces.clear();
+                    pendingSize = 0;
+                }
+            }
+            if(!pieces.empty()) regions.push_back(BuildRegion(pieces));
+            return regions;
+        }
+        //One standalone region per unit, paired with the unit's filename attribute
+        std::vector<std::pair<std::string, std::string>> SplitUnits() const{
+            std::vector<std::pair<std::string, std::string>> regions;
+            for(const Unit& unit : units){
+                regions.push_back(std::make_pair(unit.filename, BuildRegion({Piece{&unit, unit.contentBegin, unit.contentEnd, 0}})));
+            }
+            return regions;
+        }
+    private:
+        struct Unit{
+            std::size_t startTagBegin, contentBegin, contentEnd;
+            //offsets just past each top-level child of the unit
+            std::vector<std::size_t> boundaries;
+            std::string filename;
+        };
+        struct Piece{
+            const Unit* unit;
+            std::size_t begin, end, precedingNewlines;
+        };
+
+        const std::string& srcml;
+        bool isArchive;
+        std::size_t rootStart, rootTagEnd;
+        std::vector<Unit> units;
+
+        std::string BuildRegion(const std::vector<Piece>& pieces) const{
+            std::string region(srcml, 0, rootStart);
+            if(isArchive) region.append(srcml, rootStart, rootTagEnd - rootStart);
+            for(const Piece& piece : pieces){
+                region.append(srcml, piece.unit->startTagBegin, piece.unit->contentBegin - piece.unit->startTagBegin);
+                region.append(piece.precedingNewlines, '\n');
+                region.append(srcml, piece.begin, piece.end - piece.begin);
+                region.append("</unit>");
+            }
+            if(isArchive) region.append("</unit>");
+            return region;
+        }
+        //Offset just past the '>' closing the markup that starts at pos
+        std::size_t SkipMarkup(std::size_t pos) const{
+            if(srcml.compare(pos, 4, "<!--") == 0) return Advance(srcml.find("-->", pos), 3);
+            if(srcml.compare(pos, 9, "<![CDATA[") == 0) return Advance(srcml.find("]]>", pos), 3);
+            if(srcml.compare(pos, 2, "<?") == 0) return Advance(srcml.find("?>", pos), 2);
+            char quote = 0;
+            for(++pos; pos < srcml.size(); ++pos){
+                char ch = srcml[pos];
+                if(quote){
+                    if(ch == quote) quote = 0;
+                }else if(ch == '"' || ch == '\''){
+                    quote = ch;
+                }else if(ch == '>'){
+                    return pos + 1;
+                }
+            }
+            return srcml.size();
+        }
+        std::size_t Advance(std::size_t found, std::size_t length) const{
+            return found == std::string::npos ? srcml.size() : found + length;
+        }
+        //Unescaped value of attribute name in the start tag spanning [begin, end); empty if absent
+        std::string AttributeValue(std::size_t begin, std::size_t end, const std::string& name) const{
+            std::string pattern = " " + name + "=\"";
+            std::size_t found = srcml.find(pattern, begin);
+            if(found == std::string::npos || found >= end) return "";
+            std::size_t valueBegin = found + pattern.size();
+            std::size_t valueEnd = srcml.find('"', valueBegin);
+            if(valueEnd == std::string::npos || valueEnd >= end) return "";
+            return XmlUnescape(srcml.substr(valueBegin, valueEnd - valueBegin));
+        }
+        bool IsUnitTag(std::size_t pos) const{
+            return srcml.compare(pos, 5, "<unit") == 0 && pos + 5 < srcml.size() &&
+                   (std::isspace((unsigned char)srcml[pos + 5]) || srcml[pos + 5] == '>');
+        }
+        void Scan(){
+            int depth = 0, unitDepth = -1;
+            std::size_t pos = srcml.find('<');
+            while(pos != std::string::npos && pos < srcml.size()){
+                std::size_t end = SkipMarkup(pos);
+                char next = pos + 1 < srcml.size() ? srcml[pos + 1] : 0;
+                if(next == '!' || next == '?'){
+                    pos = srcml.find('<', end);
+                    continue;
+                }
+                if(next == '/'){
+                    --depth;
+                    if(depth == unitDepth){
+                        units.back().contentEnd = pos;
+                        unitDepth = -1;
+                    }else if(unitDepth >= 0 && depth == unitDepth + 1){
+                        units.back().boundaries.push_back(end);
+                    }
+                }else{
+                    bool selfClosing = srcml[end - 2] == '/';
+                    if(depth == 0){
+                        rootStart = pos;
+                        rootTagEnd = end;
+                        std::size_t child = srcml.find('<', end);
+                        isArchive = child != std::string::npos && IsUnitTag(child);
+                    }
+                    if(unitDepth < 0 && ((depth == 0 && !isArchive) || (depth == 1 && isArchive && IsUnitTag(pos)))){
+                        units.push_back(Unit{pos, end, end, {}, AttributeValue(pos, end, "filename")});
+                        unitDepth = depth;
+                    }else if(selfClosing && unitDepth >= 0 && depth == unitDepth + 1){
+                        units.back().boundaries.push_back(end);
+                    }
+                    if(!selfClosing) ++depth;
+                }
+                pos = srcml.find('<', end);
+            }
+        }
+};
+
+/*
+ * Slices each region on its own thread with its own SrcSlicePolicy, then stitches the
+ * per-region profile maps back together in document order. Declarations that repeat a
+ * name seen in an earlier region are flagged the way a serial run would flag them, alias
+ * classes are joined, and the final MergeProfiles pass resolves uses of globals declared
+ * in other regions.
+ */
+inline void ParallelSlice(const std::vector<std::string>& regions,
+                          std::unordered_map<std::string, std::vector<SliceProfile>>& profileMap, unsigned int numThreads){
+    typedef std::unordered_map<std::string, std::vector<SliceProfile>> ProfileMap;
+    std::vector<ProfileMap> regionProfiles(regions.size());
+    std::atomic<std::size_t> nextRegion(0);
+
+    xmlInitParser();
+    auto worker = [&](){
+        for(std::size_t region = nextRegion++; region < regions.size(); region = nextRegion++){
+            SrcSlicePolicy policy(&regionProfiles[region]);
+            srcSAXController control(regions[region]);
+            SrcSliceEventDispatcher<> handler({&policy});
+            control.parse(&handler);
+        }
+    };
+    std::vector<std::thread> threads;
+    for(unsigned int i = 1; i < std::max(numThreads, 1u); ++i){
+        threads.push_back(std::thread(worker));
+    }
+    worker();
+    for(std::thread& thread : threads){
+        thread.join();
+    }
+
+#if SRCSLICE_ENABLE_DVARS && SRCSLICE_ENABLE_ALIASES
+    //a region only sees its own declarations, so assigning to a pointer declared in another region was recorded as a dvar
+    std::unordered_set<std::string> pointers;
+    for(const ProfileMap& region : regionProfiles){
+        for(const auto& entry : region){
+            for(const SliceProfile& profile : entry.second){
+                if(profile.containsDeclaration && profile.potentialAlias) pointers.insert(entry.first);
+            }
+        }
+    }
+    auto declaredIn = [](const ProfileMap& region, const std::string& name){
+        auto entry = region.find(name);
+        return entry != region.end() && std::any_of(entry->second.begin(), entry->second.end(),
+            [](const SliceProfile& profile){ return profile.containsDeclaration; });
+    };
+    for(ProfileMap& region : regionProfiles){
+        for(auto& entry : region){
+            for(SliceProfile& profile : entry.second){
+                for(auto dvar = profile.dvars.begin(); dvar != profile.dvars.end();){
+                    if(!pointers.count(*dvar) || declaredIn(region, *dvar)){
+                        ++dvar;
+                        continue;
+                    }
+                    profile.aliases.insert(*dvar);
+                    dvar = profile.dvars.erase(dvar);
+                }
+            }
+        }
+    }
+#endif
+
+    for(ProfileMap& region : regionProfiles){
+        for(auto& entry : region){
+            auto existing = profileMap.find(entry.first);
+            if(existing == profileMap.end()){
+                profileMap.insert(std::make_pair(entry.first, std::move(entry.second)));
+                continue;
+            }
+            for(SliceProfile& profile : entry.second){
+                if(profile.containsDeclaration) profile.isGlobal = true;
+                existing->second.push_back(std::move(profile));
+            }
+        }
+    }
+#if SRCSLICE_ENABLE_ALIASES
+    //each region built its own alias classes; import them into one so merging profiles can join classes across regions
+    std::shared_ptr<AliasClasses> aliasClasses = std::make_shared<AliasClasses>();
+    std::unordered_map<std::shared_ptr<AliasClasses>, unsigned int> offsets;
+    for(auto& entry : profileMap){
+        for(SliceProfile& profile : entry.second){
+            std::shared_ptr<AliasClasses> regionClasses = profile.aliases.Classes();
+            if(!regionClasses){
+                profile.aliases.Attach(aliasClasses, entry.first);
+                continue;
+            }
+            auto offset = offsets.find(regionClasses);
+            if(offset == offsets.end()){
+                offset = offsets.insert(std::make_pair(regionClasses, aliasClasses->Import(*regionClasses))).first;
+            }
+            profile.aliases.Rebind(aliasClasses, offset->second);
+        }
+    }
+#endif
+    SrcSlicePolicy::MergeProfiles(profileMap);
+}
+#endif
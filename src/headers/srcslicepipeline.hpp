@@ -0,0 +1,356 @@
+/**
+ * @file srcslicepipeline.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <srcslicedispatcher.hpp>
+#include <libxml/parser.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <thread>
+#include <vector>
+#ifndef SRCSLICEPIPELINE
+#define SRCSLICEPIPELINE
+/*
+ * Bounded single-producer/single-consumer queue. Each counter is only ever written by
+ * one thread, so acquire/release on the counters is all the synchronization it needs.
+ */
+template <typename T, std::size_t capacity>
+class SPSCRing{
+    static_assert((capacity & (capacity - 1)) == 0, "capacity must be a power of two");
+    public:
+        bool TryPush(const T& item){
+            std::size_t tail = writeIndex.load(std::memory_order_relaxed);
+            if(tail - readIndex.load(std::memory_order_acquire) == capacity) return false;
+            slots[tail & (capacity - 1)] = item;
+            writeIndex.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+        bool TryPop(T& item){
+            std::size_t head = readIndex.load(std::memory_order_relaxed);
+            if(head == writeIndex.load(std::memory_order_acquire)) return false;
+            item = slots[head & (capacity - 1)];
+            readIndex.store(head + 1, std::memory_order_release);
+            return true;
+        }
+        void Push(const T& item){
+            while(!TryPush(item)) std::this_thread::yield();
+        }
+        T Pop(){
+            T item;
+            while(!TryPop(item)) std::this_thread::yield();
+            return item;
+        }
+    private:
+        //the counters sit on separate cache lines so the two threads do not false-share
+        alignas(64) std::atomic<std::size_t> writeIndex{0};
+        alignas(64) std::atomic<std::size_t> readIndex{0};
+        T slots[capacity];
+};
+
+/*
+ * A run of SAX callbacks recorded as fixed-size records. Strings are copied into one
+ * character arena and referenced by offset; element and attribute names, prefixes and
+ * URIs repeat on nearly every event, so each distinct one is stored once per batch.
+ * A batch is a handful of flat vectors that are reused once the consumer has replayed it.
+ */
+class SAXEventBatch{
+    public:
+        enum EventKind : std::uint8_t { START_DOCUMENT, END_DOCUMENT, START_ROOT, START_UNIT, START_ELEMENT,
+                                        END_ROOT, END_UNIT, END_ELEMENT, CHARACTERS_ROOT, CHARACTERS_UNIT };
+
+        SAXEventBatch() : internTable(INTERN_SLOTS, std::uint32_t(NONE)){}
+
+        void RecordDocument(EventKind kind){
+            events.push_back(Event{kind, NONE, NONE, NONE, 0, 0, 0, 0, 0});
+        }
+        void RecordStart(EventKind kind, const char * localname, const char * prefix, const char * URI,
+                         int num_namespaces, const struct srcsax_namespace * namespaces, int num_attributes,
+                         const struct srcsax_attribute * attributes){
+            Event event{kind, Intern(localname), Intern(prefix), Intern(URI), 0,
+                        (std::uint32_t)namespaceRecords.size(), (std::uint32_t)num_namespaces,
+                        (std::uint32_t)attributeRecords.size(), (std::uint32_t)num_attributes};
+            for(int i = 0; i < num_namespaces; ++i){
+                namespaceRecords.push_back(NamespaceRecord{Intern(namespaces[i].prefix), Intern(namespaces[i].uri)});
+            }
+            for(int i = 0; i < num_attributes; ++i){
+                //values such as positions are mostly unique, so they are copied rather than interned
+                attributeRecords.push_back(AttributeRecord{Intern(attributes[i].localname), Intern(attributes[i].prefix),
+                                                           Intern(attributes[i].uri), Copy(attributes[i].value)});
+            }
+            events.push_back(event);
+        }
+        void RecordEnd(EventKind kind, const char * localname, const char * prefix, const char * URI){
+            events.push_back(Event{kind, Intern(localname), Intern(prefix), Intern(URI), 0, 0, 0, 0, 0});
+        }
+        void RecordCharacters(EventKind kind, const char * ch, int len){
+            std::uint32_t offset = text.size();
+            text.insert(text.end(), ch, ch + len);
+            text.push_back('\0');
+            events.push_back(Event{kind, offset, NONE, NONE, (std::uint32_t)len, 0, 0, 0, 0});
+        }
+        //Feeds the recorded callbacks to handler in the order they were recorded
+        void Replay(srcSAXHandler& handler){
+            for(const Event& event : events){
+                switch(event.kind){
+                    case START_DOCUMENT:
+                        handler.startDocument();
+                        break;
+                    case END_DOCUMENT:
+                        handler.endDocument();
+                        break;
+                    case START_ROOT:
+                    case START_UNIT:
+                    case START_ELEMENT:{
+                        BuildScratch(event);
+                        const struct srcsax_namespace * namespaces = namespaceScratch.empty() ? 0 : namespaceScratch.data();
+                        const struct srcsax_attribute * attributes = attributeScratch.empty() ? 0 : attributeScratch.data();
+                        if(event.kind == START_ROOT){
+                            handler.startRoot(At(event.localname), At(event.prefix), At(event.uri),
+                                              event.numNamespaces, namespaces, event.numAttributes, attributes);
+                        }else if(event.kind == START_UNIT){
+                            handler.startUnit(At(event.localname), At(event.prefix), At(event.uri),
+                                              event.numNamespaces, namespaces, event.numAttributes, attributes);
+                        }else{
+                            handler.startElement(At(event.localname), At(event.prefix), At(event.uri),
+                                                 event.numNamespaces, namespaces, event.numAttributes, attributes);
+                        }
+                        break;
+                    }
+                    case END_ROOT:
+                        handler.endRoot(At(event.localname), At(event.prefix), At(event.uri));
+                        break;
+                    case END_UNIT:
+                        handler.endUnit(At(event.localname), At(event.prefix), At(event.uri));
+                        break;
+                    case END_ELEMENT:
+                        handler.endElement(At(event.localname), At(event.prefix), At(event.uri));
+                        break;
+                    case CHARACTERS_ROOT:
+                        handler.charactersRoot(At(event.localname), event.length);
+                        break;
+                    case CHARACTERS_UNIT:
+                        handler.charactersUnit(At(event.localname), event.length);
+                        break;
+                }
+            }
+        }
+        void Clear(){
+            events.clear();
+            namespaceRecords.clear();
+            attributeRecords.clear();
+            text.clear();
+            //NONE is copied so it is not bound to a reference and needs no out-of-class definition
+            std::fill(internTable.begin(), internTable.end(), std::uint32_t(NONE));
+        }
+        bool Empty() const{
+            return events.empty();
+        }
+        //Roughly the memory the batch holds; the recorder hands a batch over once this grows large
+        std::size_t Size() const{
+            return events.size() * sizeof(Event) + text.size();
+        }
+    private:
+        static const std::uint32_t NONE = 0xffffffff;
+        static const std::size_t INTERN_SLOTS = 1024;
+        static const std::size_t MAX_PROBES = 16;
+        struct Event{
+            EventKind kind;
+            //for character events localname is the text and length its size
+            std::uint32_t localname, prefix, uri, length;
+            std::uint32_t firstNamespace, numNamespaces, firstAttribute, numAttributes;
+        };
+        struct NamespaceRecord{
+            std::uint32_t prefix, uri;
+        };
+        struct AttributeRecord{
+            std::uint32_t localname, prefix, uri, value;
+        };
+
+        std::vector<Event> events;
+        std::vector<NamespaceRecord> namespaceRecords;
+        std::vector<AttributeRecord> attributeRecords;
+        std::vector<char> text;
+        //open-addressed set of interned strings, as arena offsets
+        std::vector<std::uint32_t> internTable;
+        std::vector<srcsax_namespace> namespaceScratch;
+        std::vector<srcsax_attribute> attributeScratch;
+
+        std::uint32_t Intern(const char * str){
+            if(!str) return NONE;
+            std::size_t length = std::strlen(str);
+            //FNV-1a
+            std::uint32_t hash = 2166136261u;
+            for(std::size_t i = 0; i < length; ++i){
+                hash = (hash ^ (unsigned char)str[i]) * 16777619u;
+            }
+            for(std::size_t probe = 0; probe < MAX_PROBES; ++probe){
+                std::uint32_t& slot = internTable[(hash + probe) & (INTERN_SLOTS - 1)];
+                if(slot == NONE) return slot = Copy(str, length);
+                if(std::strcmp(text.data() + slot, str) == 0) return slot;
+            }
+            //a crowded neighbourhood just stores another copy
+            return Copy(str, length);
+        }
+        std::uint32_t Copy(const char * str){
+            return str ? Copy(str, std::strlen(str)) : NONE;
+        }
+        std::uint32_t Copy(const char * str, std::size_t length){
+            std::uint32_t offset = text.size();
+            text.insert(text.end(), str, str + length + 1);
+            return offset;
+        }
+        const char * At(std::uint32_t offset) const{
+            return offset == NONE ? 0 : text.data() + offset;
+        }
+        void BuildScratch(const Event& event){
+            namespaceScratch.resize(event.numNamespaces);
+            for(std::uint32_t i = 0; i < event.numNamespaces; ++i){
+                const NamespaceRecord& record = namespaceRecords[event.firstNamespace + i];
+                namespaceScratch[i].prefix = At(record.prefix);
+                namespaceScratch[i].uri = At(record.uri);
+            }
+            attributeScratch.resize(event.numAttributes);
+            for(std::uint32_t i = 0; i < event.numAttributes; ++i){
+                const AttributeRecord& record = attributeRecords[event.firstAttribute + i];
+                attributeScratch[i].localname = At(record.localname);
+                attributeScratch[i].prefix = At(record.prefix);
+                attributeScratch[i].uri = At(record.uri);
+                attributeScratch[i].value = At(record.value);
+            }
+        }
+};
+
+typedef SPSCRing<SAXEventBatch*, 16> SAXBatchQueue;
+
+/*
+ * Producer side of the pipeline: records the callbacks the slicer needs into batches and
+ * passes full batches to the consumer. Subtrees SrcSlicePolicy::IsIgnoredElement rejects
+ * are dropped here so they never cross threads. A null batch marks the end of the parse.
+ */
+class SrcSliceEventRecorder : public srcSAXHandler{
+    public:
+        SrcSliceEventRecorder(SAXEventBatch* batch, SAXBatchQueue& filled, SAXBatchQueue& recycled) :
+            batch(batch), filled(filled), recycled(recycled){}
+
+        void startDocument() override {
+            batch->RecordDocument(SAXEventBatch::START_DOCUMENT);
+        }
+        void endDocument() override {
+            batch->RecordDocument(SAXEventBatch::END_DOCUMENT);
+        }
+        void startRoot(const char * localname, const char * prefix, const char * URI,
+                       int num_namespaces, const struct srcsax_namespace * namespaces, int num_attributes,
+                       const struct srcsax_attribute * attributes) override {
+            batch->RecordStart(SAXEventBatch::START_ROOT, localname, prefix, URI, num_namespaces, namespaces, num_attributes, attributes);
+        }
+        void startUnit(const char * localname, const char * prefix, const char * URI,
+                       int num_namespaces, const struct srcsax_namespace * namespaces, int num_attributes,
+                       const struct srcsax_attribute * attributes) override {
+            batch->RecordStart(SAXEventBatch::START_UNIT, localname, prefix, URI, num_namespaces, namespaces, num_attributes, attributes);
+        }
+        void startElement(const char * localname, const char * prefix, const char * URI,
+                          int num_namespaces, const struct srcsax_namespace * namespaces, int num_attributes,
+                          const struct srcsax_attribute * attributes) override {
+            if(ignored.SkipStart(localname, prefix, num_attributes, attributes)) return;
+            batch->RecordStart(SAXEventBatch::START_ELEMENT, localname, prefix, URI, num_namespaces, namespaces, num_attributes, attributes);
+            HandOffIfFull();
+        }
+        void endRoot(const char * localname, const char * prefix, const char * URI) override {
+            batch->RecordEnd(SAXEventBatch::END_ROOT, localname, prefix, URI);
+        }
+        void endUnit(const char * localname, const char * prefix, const char * URI) override {
+            batch->RecordEnd(SAXEventBatch::END_UNIT, localname, prefix, URI);
+            HandOffIfFull();
+        }
+        void endElement(const char * localname, const char * prefix, const char * URI) override {
+            if(ignored.SkipEnd()) return;
+            batch->RecordEnd(SAXEventBatch::END_ELEMENT, localname, prefix, URI);
+        }
+        void charactersRoot(const char * ch, int len) override {
+            batch->RecordCharacters(SAXEventBatch::CHARACTERS_ROOT, ch, len);
+        }
+        void charactersUnit(const char * ch, int len) override {
+            if(ignored.Skipping()) return;
+            batch->RecordCharacters(SAXEventBatch::CHARACTERS_UNIT, ch, len);
+            HandOffIfFull();
+        }
+        //Hands over whatever is left and tells the consumer nothing more is coming
+        void Finish(){
+            if(!batch->Empty()) filled.Push(batch);
+            filled.Push(0);
+        }
+    private:
+        //Large enough to amortize the queue handoff, small enough to stay in cache
+        static const std::size_t BATCH_BYTES = 256 * 1024;
+
+        SAXEventBatch* batch;
+        SAXBatchQueue& filled;
+        SAXBatchQueue& recycled;
+        IgnoredSubtreeFilter ignored;
+
+        void HandOffIfFull(){
+            if(batch->Size() < BATCH_BYTES) return;
+            filled.Push(batch);
+            batch = recycled.Pop();
+        }
+};
+
+/*
+ * Parses on a second thread while handler runs on the calling one, so libxml2 decoding
+ * overlaps with the dispatcher and the policies. handler sees the same callbacks in the
+ * same order as control.parse(&handler) would give it, minus the ignored subtrees.
+ */
+inline void PipelinedParse(srcSAXController& control, srcSAXHandler& handler){
+    const std::size_t NUM_BATCHES = 8;
+    std::vector<SAXEventBatch> batches(NUM_BATCHES);
+    SAXBatchQueue filled, recycled;
+    for(std::size_t i = 1; i < NUM_BATCHES; ++i){
+        recycled.Push(&batches[i]);
+    }
+
+    std::exception_ptr parseError, replayError;
+    xmlInitParser();
+    std::thread producer([&](){
+        SrcSliceEventRecorder recorder(&batches[0], filled, recycled);
+        try{
+            control.parse(&recorder);
+        }catch(...){
+            parseError = std::current_exception();
+        }
+        recorder.Finish();
+    });
+    while(SAXEventBatch* batch = filled.Pop()){
+        //after a failure keep draining so the producer never blocks on a full queue
+        if(!replayError){
+            try{
+                batch->Replay(handler);
+            }catch(...){
+                replayError = std::current_exception();
+            }
+        }
+        batch->Clear();
+        recycled.Push(batch);
+    }
+    producer.join();
+    if(parseError) std::rethrow_exception(parseError);
+    if(replayError) std::rethrow_exception(replayError);
+}
+#endif
@@ -1,6 +1,8 @@
 #ifndef SRCSLICEPOLICY
 #define SRCSLICEPOLICY
 
+#include <algorithm>
+#include <cstring>
 #include <exception>
 #include <unordered_map>
 #include <unordered_set>
@@ -12,8 +14,13 @@
 #include <srcSAXEventDispatcher.hpp>
 #include <FunctionSignaturePolicy.hpp>
 #include <FunctionCallPolicy.hpp>
+#include <GatedPolicy.hpp>
+#include <srcsliceconfig.hpp>
+#include <aliasclasses.hpp>
+#include <changeimpact.hpp>
+#include <reachingdefinitions.hpp>
 
-bool StringContainsCharacters(const std::string& str){
+inline bool StringContainsCharacters(const std::string& str){
     for(char ch : str){
         if(std::isalpha(ch)){
             return true;
@@ -31,31 +38,53 @@ class SliceProfile{
             std::vector<std::pair<std::string, std::string>> cFunc = {}, 
             std::set<std::string> dv = {}, bool containsDecl = false):
                 variableName(name), lineNumber(line), potentialAlias(alias), 
-                isGlobal(global), definitions(aDef), uses(aUse), cfunctions(cFunc), 
-                dvars(dv), containsDeclaration(containsDecl){
+                isGlobal(global), definitions(aDef), uses(aUse), containsDeclaration(containsDecl){
             
             dereferenced = false;
+#if SRCSLICE_ENABLE_CFUNCTIONS
+            cfunctions = cFunc;
+#else
+            (void)cFunc;
+#endif
+#if SRCSLICE_ENABLE_DVARS
+            dvars = dv;
+#else
+            (void)dv;
+#endif
+#if SRCSLICE_ENABLE_ALIASES
+            aliases = AliasSet(name);
+#endif
         }
 
         void PrintProfile(){
             std::cout<<"=========================================================================="<<std::endl;
             std::cout<<"Name and type: "<<variableName<<" "<<variableType<<std::endl;
+#if SRCSLICE_ENABLE_CONTAINING_CLASS
             std::cout<<"Contains Declaration: "<<containsDeclaration<<" "<<"Containing class: "<<nameOfContainingClass<<std::endl;
+#else
+            std::cout<<"Contains Declaration: "<<containsDeclaration<<std::endl;
+#endif
+#if SRCSLICE_ENABLE_DVARS
             std::cout<<"Dvars: {";
             for(auto dvar : dvars){
                 std::cout<<dvar<<",";
             }
             std::cout<<"}"<<std::endl;
+#endif
+#if SRCSLICE_ENABLE_ALIASES
             std::cout<<"Aliases: {";
             for(auto alias : aliases){
                 std::cout<<alias<<",";
             }
             std::cout<<"}"<<std::endl;
+#endif
+#if SRCSLICE_ENABLE_CFUNCTIONS
             std::cout<<"Cfunctions: {";
             for(auto cfunc : cfunctions){
                 std::cout<<cfunc.first<<" "<<cfunc.second<<",";
             }
             std::cout<<"}"<<std::endl;
+#endif
             std::cout<<"Use: {";
             for(auto use : uses){
                 std::cout<<use<<",";
@@ -73,7 +102,9 @@ class SliceProfile{
         int lineNumber;
         std::string file;
         std::string function;
+#if SRCSLICE_ENABLE_CONTAINING_CLASS
         std::string nameOfContainingClass;
+#endif
         bool potentialAlias;
         bool dereferenced;
 
@@ -87,10 +118,16 @@ class SliceProfile{
         std::set<unsigned int> definitions;
         std::set<unsigned int> uses;
         
+#if SRCSLICE_ENABLE_DVARS
         std::set<std::string> dvars;
-        std::set<std::string> aliases;
+#endif
+#if SRCSLICE_ENABLE_ALIASES
+        AliasSet aliases;
+#endif
 
+#if SRCSLICE_ENABLE_CFUNCTIONS
         std::vector<std::pair<std::string, std::string>> cfunctions;
+#endif
 };
 
 class SrcSlicePolicy : public srcSAXEventDispatch::EventListener, public srcSAXEventDispatch::PolicyDispatcher, public srcSAXEventDispatch::PolicyListener 
@@ -98,34 +135,50 @@ class SrcSlicePolicy : public srcSAXEventDispatch::EventListener, public srcSAXE
     public:
         ~SrcSlicePolicy(){};
         std::unordered_map<std::string, std::vector<SliceProfile>>* profileMap;
-        SrcSlicePolicy(std::unordered_map<std::string, std::vector<SliceProfile>>* pm, std::initializer_list<srcSAXEventDispatch::PolicyListener*> listeners = {}) : srcSAXEventDispatch::PolicyDispatcher(listeners){
+        SrcSlicePolicy(std::unordered_map<std::string, std::vector<SliceProfile>>* pm, std::initializer_list<srcSAXEventDispatch::PolicyListener*> listeners = {}) : 
+            srcSAXEventDispatch::PolicyDispatcher(listeners), 
+            declPolicy(srcSAXEventDispatch::ParserState::declstmt), 
+            initPolicy(srcSAXEventDispatch::ParserState::init), exprPolicy(srcSAXEventDispatch::ParserState::exprstmt)
+#if SRCSLICE_ENABLE_PARAMETERS
+            , paramPolicy(srcSAXEventDispatch::ParserState::parameterlist)
+#endif
+#if SRCSLICE_ENABLE_CFUNCTIONS
+            , callPolicy(srcSAXEventDispatch::ParserState::call)
+#endif
+            {
             // making SSP a listener for FSPP
             InitializeEventHandlers();
         
             declPolicy.AddListener(this);
             exprPolicy.AddListener(this);
-            callPolicy.AddListener(this);
             initPolicy.AddListener(this);
+#if SRCSLICE_ENABLE_CFUNCTIONS
+            callPolicy.AddListener(this);
+#endif
+#if SRCSLICE_ENABLE_PARAMETERS
             paramPolicy.AddListener(this);
+#endif
 
             profileMap = pm;
         }
         void Notify(const PolicyDispatcher *policy, const srcSAXEventDispatch::srcSAXEventContext &ctx) override {
             using namespace srcSAXEventDispatch;
-            if(typeid(DeclTypePolicy) == typeid(*policy)){
+            if(policy == &declPolicy){
                 decldata = *policy->Data<DeclData>();
+                RecordLine(decldata.nameOfIdentifier, decldata.lineNumber, LineIndex::DEFINITION, ctx);
+                TrackStatement({std::make_pair(decldata.nameOfIdentifier, decldata.lineNumber)}, {});
                 auto sliceProfileItr = profileMap->find(decldata.nameOfIdentifier);
                 
                 //Just add new slice profile if name already exists. Otherwise, add new entry in map.
                 if(sliceProfileItr != profileMap->end()){
                     auto sliceProfile = SliceProfile(decldata.nameOfIdentifier,decldata.lineNumber, (decldata.isPointer || decldata.isReference), true, std::set<unsigned int>{decldata.lineNumber});
-                    sliceProfile.nameOfContainingClass = ctx.currentClassName;
+                    SetContext(sliceProfile, ctx);
                     sliceProfileItr->second.push_back(sliceProfile);
                     sliceProfileItr->second.back().containsDeclaration = true;
                 }else{
                     auto sliceProf = SliceProfile(decldata.nameOfIdentifier,decldata.lineNumber,
                                     (decldata.isPointer || decldata.isReference), false, std::set<unsigned int>{decldata.lineNumber});
-                    sliceProf.nameOfContainingClass = ctx.currentClassName;
+                    SetContext(sliceProf, ctx);
                     sliceProf.containsDeclaration = true;
                     profileMap->insert(std::make_pair(decldata.nameOfIdentifier, 
                         std::vector<SliceProfile>{
@@ -139,47 +192,57 @@ class SrcSlicePolicy : public srcSAXEventDispatch::EventListener, public srcSAXE
                     if(updateDvarAtThisLocation != profileMap->end()){
                         if(!StringContainsCharacters(decldata.nameOfIdentifier)) continue;
                         if(sliceProfileItr != profileMap->end() && sliceProfileItr->second.back().potentialAlias){
-                            updateDvarAtThisLocation->second.back().aliases.insert(decldata.nameOfIdentifier);
+                            AddAlias(updateDvarAtThisLocation->second.back(), decldata.nameOfIdentifier);
                             continue;
                         }
-                        updateDvarAtThisLocation->second.back().dvars.insert(decldata.nameOfIdentifier);
+                        AddDvar(updateDvarAtThisLocation->second.back(), decldata.nameOfIdentifier);
                     }else{
                         auto sliceProf = SliceProfile(dvar, decldata.lineNumber, false, false, std::set<unsigned int>{}, std::set<unsigned int>{decldata.lineNumber});
-                        sliceProf.nameOfContainingClass = ctx.currentClassName;
+                        SetContext(sliceProf, ctx);
                         auto newSliceProfileFromDeclDvars = profileMap->insert(std::make_pair(dvar, 
                             std::vector<SliceProfile>{
                                 std::move(sliceProf)
                             }));
                         if(!StringContainsCharacters(decldata.nameOfIdentifier)) continue;
                         if(sliceProfileItr != profileMap->end() && sliceProfileItr->second.back().potentialAlias){
-                            newSliceProfileFromDeclDvars.first->second.back().aliases.insert(decldata.nameOfIdentifier);
+                            AddAlias(newSliceProfileFromDeclDvars.first->second.back(), decldata.nameOfIdentifier);
                             continue;
                         }
-                        newSliceProfileFromDeclDvars.first->second.back().dvars.insert(decldata.nameOfIdentifier);
+                        AddDvar(newSliceProfileFromDeclDvars.first->second.back(), decldata.nameOfIdentifier);
                     }
                 }
                 declDvars.clear();
                 decldata.clear();
-            }else if(typeid(ExprPolicy) == typeid(*policy)){
+            }else if(policy == &exprPolicy){
                 exprDataSet = *policy->Data<ExprPolicy::ExprDataSet>();
+                if(computeDefUseChains && functionDepth){
+                    ReachingDefinitions::NameLineList defs, uses;
+                    for(const auto& exprdata : exprDataSet.dataSet){
+                        for(unsigned int line : exprdata.second.definitions) defs.push_back(std::make_pair(exprdata.second.nameOfIdentifier, line));
+                        for(unsigned int line : exprdata.second.uses) uses.push_back(std::make_pair(exprdata.second.nameOfIdentifier, line));
+                    }
+                    TrackStatement(defs, uses);
+                }
                 //iterate through every token found in the expression statement
                 for(auto exprdata : exprDataSet.dataSet){
+                    RecordLines(exprdata.second.nameOfIdentifier, exprdata.second.definitions, LineIndex::DEFINITION, ctx);
+                    RecordLines(exprdata.second.nameOfIdentifier, exprdata.second.uses, LineIndex::USE, ctx);
                     auto sliceProfileExprItr = profileMap->find(exprdata.second.nameOfIdentifier);
                     auto sliceProfileLHSItr = profileMap->find(exprDataSet.lhsName);
                     //Just update definitions and uses if name already exists. Otherwise, add new name.
                     if(sliceProfileExprItr != profileMap->end()){
-                        sliceProfileExprItr->second.back().nameOfContainingClass = ctx.currentClassName;
+                        SetContainingClass(sliceProfileExprItr->second.back(), ctx);
                         sliceProfileExprItr->second.back().uses.insert(exprdata.second.uses.begin(), exprdata.second.uses.end());
                         sliceProfileExprItr->second.back().definitions.insert(exprdata.second.definitions.begin(), exprdata.second.definitions.end());
                         
                         if(!StringContainsCharacters(exprDataSet.lhsName)) continue;
                         if(sliceProfileLHSItr!= profileMap->end() && sliceProfileLHSItr->second.back().potentialAlias){ 
-                            sliceProfileExprItr->second.back().aliases.insert(exprDataSet.lhsName);
+                            AddAlias(sliceProfileExprItr->second.back(), exprDataSet.lhsName);
                             continue;
                         }
                         if(!StringContainsCharacters(currentName)) continue;
                         if(!currentName.empty() && (exprdata.second.lhs || currentName!=exprdata.second.nameOfIdentifier)){
-                            sliceProfileExprItr->second.back().dvars.insert(currentName);
+                            AddDvar(sliceProfileExprItr->second.back(), currentName);
                             continue;
                         }
                         
@@ -189,27 +252,36 @@ class SrcSlicePolicy : public srcSAXEventDispatch::EventListener, public srcSAXE
                                 SliceProfile(exprdata.second.nameOfIdentifier, ctx.currentLineNumber, false, false, 
                                     exprdata.second.definitions, exprdata.second.uses)
                             }));
-                        sliceProfileExprItr2.first->second.back().nameOfContainingClass = ctx.currentClassName;
+                        SetContext(sliceProfileExprItr2.first->second.back(), ctx);
                         
                         if(!StringContainsCharacters(exprDataSet.lhsName)) continue;
                         if(sliceProfileLHSItr!= profileMap->end() && sliceProfileLHSItr->second.back().potentialAlias){
-                            sliceProfileExprItr2.first->second.back().aliases.insert(exprDataSet.lhsName);
+                            AddAlias(sliceProfileExprItr2.first->second.back(), exprDataSet.lhsName);
                             continue;
                         }
                         //Only ever record a variable as being a dvar of itself if it was seen on both sides of =
                         if(!StringContainsCharacters(currentName)) continue;
                         if(!currentName.empty() && (exprdata.second.lhs || currentName!=exprdata.second.nameOfIdentifier)){
-                            sliceProfileExprItr2.first->second.back().dvars.insert(currentName);
+                            AddDvar(sliceProfileExprItr2.first->second.back(), currentName);
                             continue;
                         }
                     }
                 }
                 exprDataSet.clear();
-            }else if(typeid(InitPolicy) == typeid(*policy)){
+            }else if(policy == &initPolicy){
                 initDataSet = *policy->Data<InitPolicy::InitDataSet>();
+                //an initializer inside a for header is tracked with the rest of the header
+                if(computeDefUseChains && functionDepth && !InControlHeader()){
+                    ReachingDefinitions::NameLineList uses;
+                    for(const auto& initdata : initDataSet.dataSet){
+                        for(unsigned int line : initdata.second.uses) uses.push_back(std::make_pair(initdata.second.nameOfIdentifier, line));
+                    }
+                    TrackStatement({}, uses);
+                }
                 //iterate through every token found in the initialization of a decl_stmt
                 for(auto initdata : initDataSet.dataSet){
                     declDvars.push_back(initdata.second.nameOfIdentifier);
+                    RecordLines(initdata.second.nameOfIdentifier, initdata.second.uses, LineIndex::USE, ctx);
                     auto sliceProfileItr = profileMap->find(initdata.second.nameOfIdentifier);
                     //Just update definitions and uses if name already exists. Otherwise, add new name.
                     if(sliceProfileItr != profileMap->end()){
@@ -217,13 +289,14 @@ class SrcSlicePolicy : public srcSAXEventDispatch::EventListener, public srcSAXE
                     }else{
                         auto sliceProf = SliceProfile(initdata.second.nameOfIdentifier, ctx.currentLineNumber, false, false, 
                                     std::set<unsigned int>{}, initdata.second.uses);
-                        sliceProf.nameOfContainingClass = ctx.currentClassName;
+                        SetContext(sliceProf, ctx);
                         profileMap->insert(std::make_pair(initdata.second.nameOfIdentifier, 
                             std::vector<SliceProfile>{sliceProf}));
                     }   
                 }
                 initDataSet.clear();
-            }else if(typeid(CallPolicy) == typeid(*policy)){
+#if SRCSLICE_ENABLE_CFUNCTIONS
+            }else if(policy == &callPolicy){
                 calldata = *policy->Data<CallPolicy::CallData>();
                 bool isFuncNameNext = false;
                 std::vector<std::pair<std::string, unsigned int>> funcNameAndCurrArgumentPos;
@@ -249,6 +322,7 @@ class SrcSlicePolicy : public srcSAXEventDispatch::EventListener, public srcSAXE
                         isFuncNameNext = false;
                     }else{
                         auto sliceProfileItr = profileMap->find(currentCallToken);
+                        RecordLine(currentCallToken, ctx.currentLineNumber, LineIndex::USE, ctx);
                         
                         std::string callOrder, argumentOrder;
                         for(auto name : funcNameAndCurrArgumentPos){
@@ -266,34 +340,107 @@ class SrcSlicePolicy : public srcSAXEventDispatch::EventListener, public srcSAXE
                             auto sliceProf = SliceProfile(currentCallToken, ctx.currentLineNumber, true, true, 
                                         std::set<unsigned int>{}, std::set<unsigned int>{ctx.currentLineNumber}, 
                                         std::vector<std::pair<std::string, std::string>>{std::make_pair(callOrder, argumentOrder)});
-                            sliceProf.nameOfContainingClass = ctx.currentClassName;
+                            SetContext(sliceProf, ctx);
                             profileMap->insert(std::make_pair(currentCallToken, 
                                 std::vector<SliceProfile>{sliceProf}));
                         }
                         if(!funcNameAndCurrArgumentPos.empty()) ++funcNameAndCurrArgumentPos.back().second;
                     }
                 }
-            }else if(typeid(ParamTypePolicy) == typeid(*policy)){
+#endif
+#if SRCSLICE_ENABLE_PARAMETERS
+            }else if(policy == &paramPolicy){
                 paramdata = *policy->Data<DeclData>();
+                RecordLine(paramdata.nameOfIdentifier, paramdata.lineNumber, LineIndex::DEFINITION, ctx);
+                if(computeDefUseChains && functionDepth){
+                    reachingDefinitions.AddParameter(paramdata.nameOfIdentifier, paramdata.lineNumber);
+                }
                 //record parameter data-- this is done exact as it is done for decl_stmts except there's no initializer
                 auto sliceProfileItr = profileMap->find(paramdata.nameOfIdentifier);
                 //Just add new slice profile if name already exists. Otherwise, add new entry in map.
                 if(sliceProfileItr != profileMap->end()){
                     auto sliceProf = SliceProfile(paramdata.nameOfIdentifier,paramdata.lineNumber, (paramdata.isPointer || paramdata.isReference), true, std::set<unsigned int>{paramdata.lineNumber});
                     sliceProf.containsDeclaration = true;
-                    sliceProf.nameOfContainingClass = ctx.currentClassName;
+                    SetContext(sliceProf, ctx);
                     sliceProfileItr->second.push_back(std::move(sliceProf));
                 }else{
                     auto sliceProf = SliceProfile(paramdata.nameOfIdentifier,paramdata.lineNumber, (paramdata.isPointer || paramdata.isReference), true, std::set<unsigned int>{paramdata.lineNumber});
                     sliceProf.containsDeclaration = true;
-                    sliceProf.nameOfContainingClass = ctx.currentClassName;
+                    SetContext(sliceProf, ctx);
                     profileMap->insert(std::make_pair(paramdata.nameOfIdentifier, 
                         std::vector<SliceProfile>{std::move(sliceProf)}));
                 }
                 paramdata.clear();
+#endif
             }
         }
         void NotifyWrite(const PolicyDispatcher *policy, srcSAXEventDispatch::srcSAXEventContext &ctx){}
+
+        /*
+         * Elements whose subtrees never contribute to a slice: comments, preprocessor
+         * directives, literals, specifiers and template argument lists. A dispatcher
+         * may drop these wholesale before they reach any policy (see SrcSliceEventDispatcher).
+         */
+        static bool IsIgnoredElement(const char* localname, const char* prefix, int num_attributes, const struct srcsax_attribute* attributes){
+            if(prefix && std::strcmp(prefix, "cpp") == 0) return true;
+            if(std::strcmp(localname, "comment") == 0 || std::strcmp(localname, "literal") == 0 || std::strcmp(localname, "specifier") == 0) return true;
+            if(std::strcmp(localname, "argument_list") == 0){
+                for(int i = 0; i < num_attributes; ++i){
+                    if(std::strcmp(attributes[i].localname, "type") == 0 && std::strcmp(attributes[i].value, "generic") == 0) return true;
+                }
+            }
+            return false;
+        }
+
+        //Fold every profile without a declaration into the first declared profile of the same name
+        static void MergeProfiles(std::unordered_map<std::string, std::vector<SliceProfile>>& profileMap){
+            for(std::unordered_map<std::string, std::vector<SliceProfile>>::iterator it = profileMap.begin(); it != profileMap.end(); ++it){
+                std::vector<SliceProfile>& profiles = it->second;
+                std::vector<SliceProfile>::iterator declIt = std::find_if(profiles.begin(), profiles.end(), 
+                    [](const SliceProfile& profile){ return profile.containsDeclaration; });
+                if(declIt == profiles.end() || std::all_of(profiles.begin(), profiles.end(), 
+                    [](const SliceProfile& profile){ return profile.containsDeclaration; })) continue;
+                SliceProfile declared = *declIt;
+                std::vector<SliceProfile> merged;
+                for(SliceProfile& profile : profiles){
+                    if(profile.containsDeclaration){
+                        merged.push_back(std::move(profile));
+                        continue;
+                    }
+                    declared.uses.insert(profile.uses.begin(), profile.uses.end());
+                    declared.definitions.insert(profile.definitions.begin(), profile.definitions.end());
+#if SRCSLICE_ENABLE_DVARS
+                    declared.dvars.insert(profile.dvars.begin(), profile.dvars.end());
+#endif
+#if SRCSLICE_ENABLE_ALIASES
+                    declared.aliases.Join(profile.aliases);
+#endif
+#if SRCSLICE_ENABLE_CFUNCTIONS
+                    declared.cfunctions.reserve(declared.cfunctions.size() + profile.cfunctions.size());
+                    declared.cfunctions.insert(declared.cfunctions.end(), profile.cfunctions.begin(), profile.cfunctions.end());
+#endif
+                }
+                merged.front() = std::move(declared);
+                profiles.swap(merged);
+            }
+        }
+
+        //Record every definition and use line into index; it is sealed when the archive closes
+        void SetLineIndex(LineIndex* index){
+            lineIndex = index;
+        }
+        //Offer every definition to impact, which keeps those on changed lines; see ChangeImpact
+        void SetChangeImpact(ChangeImpact* impact){
+            changeImpact = impact;
+        }
+
+        //Def-use chains from per-function reaching definitions; off by default since it costs a dataflow pass per function
+        void EnableDefUseChains(bool enable){
+            computeDefUseChains = enable;
+        }
+        const std::vector<DefUseChain>& DefUseChains() const{
+            return defUseChains;
+        }
     
     protected:
         void *DataInner() const override {
@@ -301,69 +448,329 @@ class SrcSlicePolicy : public srcSAXEventDispatch::EventListener, public srcSAXE
         }
         
     private:
-        DeclTypePolicy declPolicy;
+        //Sub-policies stay registered for the whole parse and gate themselves on their trigger element
+        GatedPolicy<DeclTypePolicy> declPolicy;
         DeclData decldata;
 
-        ParamTypePolicy paramPolicy;
+#if SRCSLICE_ENABLE_PARAMETERS
+        GatedPolicy<ParamTypePolicy> paramPolicy;
         DeclData paramdata;
+#endif
 
-        InitPolicy initPolicy;
+        GatedPolicy<InitPolicy> initPolicy;
         InitPolicy::InitDataSet initDataSet;
         
         ExprPolicy::ExprDataSet exprDataSet;
-        ExprPolicy exprPolicy;  
+        GatedPolicy<ExprPolicy> exprPolicy;  
         
-        CallPolicy callPolicy;
+#if SRCSLICE_ENABLE_CFUNCTIONS
+        GatedPolicy<CallPolicy> callPolicy;
         CallPolicy::CallData calldata;
+#endif
 
         FunctionSignaturePolicy functionpolicy;
         std::string currentExprName;
         std::vector<std::string> declDvars;
 
         std::string currentName;
+
+#if SRCSLICE_ENABLE_ALIASES
+        std::shared_ptr<AliasClasses> aliasClasses = std::make_shared<AliasClasses>();
+#endif
+        //Every new profile records where it was seen and joins this policy's alias classes as a member of its own
+        void SetContext(SliceProfile& profile, const srcSAXEventDispatch::srcSAXEventContext& ctx){
+            SetContainingClass(profile, ctx);
+            profile.file = ctx.currentFilePath;
+#if SRCSLICE_ENABLE_ALIASES
+            profile.aliases.Attach(aliasClasses, profile.variableName);
+#endif
+        }
+        //The helpers below compile to nothing when their feature is disabled in srcsliceconfig.hpp
+        static void SetContainingClass(SliceProfile& profile, const srcSAXEventDispatch::srcSAXEventContext& ctx){
+#if SRCSLICE_ENABLE_CONTAINING_CLASS
+            profile.nameOfContainingClass = ctx.currentClassName;
+#else
+            (void)profile; (void)ctx;
+#endif
+        }
+        static void AddDvar(SliceProfile& profile, const std::string& name){
+#if SRCSLICE_ENABLE_DVARS
+            profile.dvars.insert(name);
+#else
+            (void)profile; (void)name;
+#endif
+        }
+        static void AddAlias(SliceProfile& profile, const std::string& name){
+#if SRCSLICE_ENABLE_ALIASES
+            profile.aliases.insert(name);
+#else
+            (void)profile; (void)name;
+#endif
+        }
+        const void* attachedDispatcher = nullptr;
+
+        LineIndex* lineIndex = nullptr;
+        ChangeImpact* changeImpact = nullptr;
+        void RecordLine(const std::string& name, unsigned int line, LineIndex::Kind kind, const srcSAXEventDispatch::srcSAXEventContext& ctx){
+            if(lineIndex){
+                lineIndex->Record(ctx.currentFilePath, line, name, kind);
+            }
+            if(changeImpact && kind == LineIndex::DEFINITION){
+                changeImpact->RecordDefinition(ctx.currentFilePath, line, name);
+            }
+        }
+        template<typename Lines>
+        void RecordLines(const std::string& name, const Lines& lines, LineIndex::Kind kind, const srcSAXEventDispatch::srcSAXEventContext& ctx){
+            if(!lineIndex && !changeImpact) return;
+            for(unsigned int line : lines){
+                RecordLine(name, line, kind, ctx);
+            }
+        }
+
+        bool computeDefUseChains = false;
+        unsigned int functionDepth = 0;
+        ReachingDefinitions reachingDefinitions;
+        std::vector<DefUseChain> defUseChains;
+        void TrackStatement(const ReachingDefinitions::NameLineList& defs, const ReachingDefinitions::NameLineList& uses){
+            if(computeDefUseChains && functionDepth){
+                reachingDefinitions.AddStatement(defs, uses);
+            }
+        }
+
+        /*
+         * Conditions and for init/increment are not statements, so their defs and uses are
+         * collected token by token into the innermost control frame and tracked as one
+         * statement each once that part of the header ends.
+         */
+        enum ControlPhase { CONTROL_INIT, CONTROL_CONDITION, CONTROL_INCREMENT, CONTROL_BODY };
+        struct ControlFrame{
+            ControlFrame(srcSAXEventDispatch::ParserState state, ControlPhase start) : kind(state), phase(start){}
+            srcSAXEventDispatch::ParserState kind;
+            ControlPhase phase;
+            ReachingDefinitions::NameLineList defs, uses;
+        };
+        std::vector<ControlFrame> controlFrames;
+        //whether each open else reopened an if that had already closed
+        std::vector<bool> reopenedElses;
+        bool elseMayReopen = false;
+        std::string lastOperand;
+        bool pendingIncDec = false;
+        bool declNameSeen = false;
+
+        bool InControlHeader() const{
+            return !controlFrames.empty() && controlFrames.back().phase != CONTROL_BODY;
+        }
+        void BeginControl(srcSAXEventDispatch::ParserState kind, ControlPhase phase){
+            controlFrames.push_back(ControlFrame(kind, phase));
+            lastOperand.clear();
+            pendingIncDec = false;
+        }
+        void FlushControl(){
+            ControlFrame& frame = controlFrames.back();
+            TrackStatement(frame.defs, frame.uses);
+            frame.defs.clear();
+            frame.uses.clear();
+            lastOperand.clear();
+            pendingIncDec = false;
+        }
+        void ControlToken(const srcSAXEventDispatch::srcSAXEventContext& ctx){
+            using namespace srcSAXEventDispatch;
+            if(!ctx.IsOpen(ParserState::name) || !ctx.Nor({ParserState::type, ParserState::specifier, ParserState::modifier}) ||
+               !StringContainsCharacters(ctx.currentToken)){
+                //punctuation such as ( or ] separates an operand from a following ++ or =
+                lastOperand.clear();
+                return;
+            }
+            ControlFrame& frame = controlFrames.back();
+            std::pair<std::string, unsigned int> operand = std::make_pair(ctx.currentToken, ctx.currentLineNumber);
+            if(ctx.IsOpen(ParserState::decl) && !declNameSeen){
+                declNameSeen = true;
+                frame.defs.push_back(operand);
+                return;
+            }
+            frame.uses.push_back(operand);
+            if(pendingIncDec) frame.defs.push_back(operand);
+            pendingIncDec = false;
+            lastOperand = ctx.currentToken;
+        }
+        void ControlOperator(const std::string& op, unsigned int line){
+            ControlFrame& frame = controlFrames.back();
+            bool assignment = op.size() >= 2 && op.back() == '=' && op != "==" && op != "!=" && op != "<=" && op != ">=";
+            if(op == "++" || op == "--"){
+                if(lastOperand.empty()) pendingIncDec = true;
+                else frame.defs.push_back(std::make_pair(lastOperand, line));
+            }else if(!lastOperand.empty() && (op == "=" || assignment)){
+                //a plain assignment does not read its target
+                if(op == "=" && !frame.uses.empty() && frame.uses.back().first == lastOperand) frame.uses.pop_back();
+                frame.defs.push_back(std::make_pair(lastOperand, line));
+            }
+            lastOperand.clear();
+        }
+
         void InitializeEventHandlers(){
             using namespace srcSAXEventDispatch;
-            closeEventMap[ParserState::op] = [this](srcSAXEventContext& ctx){
-                if(ctx.currentToken == "="){
-                    currentName = currentExprName;
+            //Nested functions (lambdas, local classes) are folded into the outermost one
+            openEventMap[ParserState::function] = [this](srcSAXEventContext&){
+                if(computeDefUseChains && functionDepth++ == 0){
+                    reachingDefinitions.BeginFunction();
+                    controlFrames.clear();
+                    reopenedElses.clear();
                 }
             };
-            openEventMap[ParserState::declstmt] = [this](srcSAXEventContext& ctx){
-                ctx.dispatcher->AddListenerDispatch(&declPolicy);
+            closeEventMap[ParserState::function] = [this](srcSAXEventContext&){
+                if(computeDefUseChains && functionDepth && --functionDepth == 0){
+                    std::vector<DefUseChain> chains = reachingDefinitions.EndFunction();
+                    defUseChains.insert(defUseChains.end(), chains.begin(), chains.end());
+                }
             };
-            openEventMap[ParserState::parameterlist] = [this](srcSAXEventContext& ctx) {
-                ctx.dispatcher->AddListenerDispatch(&paramPolicy);
+            openEventMap[ParserState::ifstmt] = [this](srcSAXEventContext&){
+                if(!functionDepth) return;
+                reachingDefinitions.BeginBranch();
+                BeginControl(ParserState::ifstmt, CONTROL_CONDITION);
             };
-            openEventMap[ParserState::exprstmt] = [this](srcSAXEventContext& ctx){
-                ctx.dispatcher->AddListenerDispatch(&exprPolicy);
+            closeEventMap[ParserState::ifstmt] = [this](srcSAXEventContext&){
+                if(!functionDepth) return;
+                controlFrames.pop_back();
+                reachingDefinitions.EndRegion();
+                elseMayReopen = true;
             };
-            openEventMap[ParserState::call] = [this](srcSAXEventContext& ctx){
-                //don't want multiple callPolicy parsers running
-                if(ctx.NumCurrentlyOpen(ParserState::call) < 2) {
-                    ctx.dispatcher->AddListenerDispatch(&callPolicy);
+            openEventMap[ParserState::switchstmt] = [this](srcSAXEventContext&){
+                if(!functionDepth) return;
+                reachingDefinitions.BeginBranch();
+                BeginControl(ParserState::switchstmt, CONTROL_CONDITION);
+            };
+            closeEventMap[ParserState::switchstmt] = [this](srcSAXEventContext&){
+                if(!functionDepth) return;
+                controlFrames.pop_back();
+                reachingDefinitions.EndRegion();
+            };
+            openEventMap[ParserState::switchcase] = [this](srcSAXEventContext&){
+                if(functionDepth && !controlFrames.empty() && controlFrames.back().kind == ParserState::switchstmt){
+                    reachingDefinitions.NextArm(true);
                 }
             };
-            openEventMap[ParserState::init] = [this](srcSAXEventContext& ctx){
-                ctx.dispatcher->AddListenerDispatch(&initPolicy);
+            /*
+             * An else is an arm of the if it sits in, or, where the srcML closes the if
+             * before its else, of the branch that closed right before it. A block closing
+             * in between means that branch was nested in a then arm instead.
+             */
+            openEventMap[ParserState::elsestmt] = [this](srcSAXEventContext&){
+                if(!functionDepth) return;
+                if(elseMayReopen && reachingDefinitions.ReopenBranch()){
+                    reopenedElses.push_back(true);
+                    return;
+                }
+                if(!controlFrames.empty() && controlFrames.back().kind == ParserState::ifstmt){
+                    reachingDefinitions.NextArm();
+                }
+                reopenedElses.push_back(false);
+            };
+            closeEventMap[ParserState::elsestmt] = [this](srcSAXEventContext&){
+                if(!functionDepth || reopenedElses.empty()) return;
+                if(reopenedElses.back()) reachingDefinitions.EndRegion();
+                reopenedElses.pop_back();
+            };
+            openEventMap[ParserState::whilestmt] = [this](srcSAXEventContext&){
+                if(!functionDepth) return;
+                reachingDefinitions.BeginLoop();
+                BeginControl(ParserState::whilestmt, CONTROL_CONDITION);
+            };
+            closeEventMap[ParserState::whilestmt] = [this](srcSAXEventContext&){
+                if(!functionDepth) return;
+                controlFrames.pop_back();
+                reachingDefinitions.EndRegion();
+            };
+            //init runs once before the loop; the increment is tracked after the body
+            openEventMap[ParserState::forstmt] = [this](srcSAXEventContext&){
+                if(!functionDepth) return;
+                reachingDefinitions.BeginLoop();
+                BeginControl(ParserState::forstmt, CONTROL_INIT);
             };
-            closeEventMap[ParserState::call] = [this](srcSAXEventContext& ctx){
-                if(ctx.NumCurrentlyOpen(ParserState::call) < 2) {
-                    ctx.dispatcher->RemoveListenerDispatch(&callPolicy);
+            closeEventMap[ParserState::forstmt] = [this](srcSAXEventContext&){
+                if(!functionDepth) return;
+                FlushControl();
+                controlFrames.pop_back();
+                reachingDefinitions.EndRegion();
+            };
+            //a do's body comes first, so its frame stays in the body until the condition
+            openEventMap[ParserState::dostmt] = [this](srcSAXEventContext&){
+                if(!functionDepth) return;
+                reachingDefinitions.BeginLoop();
+                BeginControl(ParserState::dostmt, CONTROL_BODY);
+            };
+            closeEventMap[ParserState::dostmt] = [this](srcSAXEventContext&){
+                if(!functionDepth) return;
+                controlFrames.pop_back();
+                reachingDefinitions.EndRegion();
+            };
+            openEventMap[ParserState::condition] = [this](srcSAXEventContext& ctx){
+                if(!functionDepth || controlFrames.empty()) return;
+                ControlFrame& frame = controlFrames.back();
+                if(frame.kind == ParserState::dostmt && frame.phase == CONTROL_BODY && ctx.Nor({ParserState::exprstmt, ParserState::declstmt})){
+                    frame.phase = CONTROL_CONDITION;
                 }
+                if(!InControlHeader()) return;
+                if(frame.kind == ParserState::forstmt && frame.phase == CONTROL_INIT){
+                    FlushControl();
+                    reachingDefinitions.MarkRegionEntry();
+                }
+                frame.phase = CONTROL_CONDITION;
             };
-            closeEventMap[ParserState::declstmt] = [this](srcSAXEventContext& ctx){
-                ctx.dispatcher->RemoveListenerDispatch(&declPolicy);
-                currentName.clear();
+            closeEventMap[ParserState::condition] = [this](srcSAXEventContext&){
+                if(!functionDepth || !InControlHeader()) return;
+                FlushControl();
+                ControlFrame& frame = controlFrames.back();
+                //arms start after the condition; a loop leaves from it
+                if(frame.kind == ParserState::ifstmt || frame.kind == ParserState::switchstmt){
+                    reachingDefinitions.MarkRegionEntry();
+                }else{
+                    reachingDefinitions.MarkLoopExit();
+                }
+                frame.phase = frame.kind == ParserState::forstmt ? CONTROL_INCREMENT : CONTROL_BODY;
             };
-            closeEventMap[ParserState::exprstmt] = [this](srcSAXEventContext& ctx){
-                ctx.dispatcher->RemoveListenerDispatch(&exprPolicy);
-                currentName.clear();
+            openEventMap[ParserState::block] = [this](srcSAXEventContext&){
+                if(!functionDepth || !InControlHeader()) return;
+                ControlFrame& frame = controlFrames.back();
+                //a for without a condition goes straight from init to the body
+                if(frame.kind == ParserState::forstmt && frame.phase == CONTROL_INIT){
+                    FlushControl();
+                    reachingDefinitions.MarkRegionEntry();
+                }
+                frame.phase = CONTROL_BODY;
+            };
+            closeEventMap[ParserState::block] = [this](srcSAXEventContext&){
+                elseMayReopen = false;
             };
-            closeEventMap[ParserState::init] = [this](srcSAXEventContext& ctx){
-                ctx.dispatcher->RemoveListenerDispatch(&initPolicy);
+            openEventMap[ParserState::decl] = [this](srcSAXEventContext&){
+                declNameSeen = false;
             };
-            closeEventMap[ParserState::parameterlist] = [this](srcSAXEventContext& ctx) {
-                ctx.dispatcher->RemoveListenerDispatch(&paramPolicy);
+            closeEventMap[ParserState::op] = [this](srcSAXEventContext& ctx){
+                if(ctx.currentToken == "="){
+                    currentName = currentExprName;
+                }
+                if(functionDepth && InControlHeader() && ctx.Nor({ParserState::exprstmt, ParserState::declstmt})){
+                    ControlOperator(ctx.currentToken, ctx.currentLineNumber);
+                }
+            };
+            openEventMap[ParserState::unit] = [this](srcSAXEventContext& ctx){
+                //attach once per dispatcher; the gates decide when each sub-policy sees events
+                if(attachedDispatcher == ctx.dispatcher) return;
+                attachedDispatcher = ctx.dispatcher;
+                ctx.dispatcher->AddListenerDispatch(&declPolicy);
+                ctx.dispatcher->AddListenerDispatch(&exprPolicy);
+                ctx.dispatcher->AddListenerDispatch(&initPolicy);
+#if SRCSLICE_ENABLE_PARAMETERS
+                ctx.dispatcher->AddListenerDispatch(&paramPolicy);
+#endif
+#if SRCSLICE_ENABLE_CFUNCTIONS
+                ctx.dispatcher->AddListenerDispatch(&callPolicy);
+#endif
+            };
+            closeEventMap[ParserState::declstmt] = [this](srcSAXEventContext&){
+                currentName.clear();
+            };
+            closeEventMap[ParserState::exprstmt] = [this](srcSAXEventContext&){
+                currentName.clear();
             };
             closeEventMap[ParserState::tokenstring] = [this](srcSAXEventContext& ctx){
                 //TODO: possibly, this if-statement is suppressing more than just unmarked whitespace. Investigate.
@@ -371,32 +778,15 @@ class SrcSlicePolicy : public srcSAXEventDispatch::EventListener, public srcSAXE
                     if(ctx.And({ParserState::name, ParserState::expr, ParserState::exprstmt}) && ctx.Nor({ParserState::specifier, ParserState::modifier, ParserState::op})){
                         currentExprName = ctx.currentToken;
                     }
-                }
-            };
-            closeEventMap[ParserState::archive] = [this](srcSAXEventContext& ctx){
-                for(std::unordered_map<std::string, std::vector<SliceProfile>>::iterator it = profileMap->begin(); it != profileMap->end(); ++it){
-                    for(std::vector<SliceProfile>::iterator sIt = it->second.begin(); sIt!=it->second.end(); ++sIt){
-                        if(sIt->containsDeclaration){
-                            std::vector<SliceProfile>::iterator sIt2 = it->second.begin();
-                            while(sIt2!=it->second.end()){
-                                if(!sIt2->containsDeclaration){
-                                    std::cout<<"NAME: "<<sIt2->variableName<<std::endl;
-                                    sIt->uses.insert(sIt2->uses.begin(), sIt2->uses.end());
-                                    sIt->definitions.insert(sIt2->definitions.begin(), sIt2->definitions.end());
-                                    sIt->dvars.insert(sIt2->dvars.begin(), sIt2->dvars.end());
-                                    sIt->aliases.insert(sIt2->aliases.begin(), sIt2->aliases.end());
-                                    sIt->cfunctions.reserve(sIt->cfunctions.size() + sIt2->cfunctions.size());
-                                    sIt->cfunctions.insert(sIt->cfunctions.end(), sIt2->cfunctions.begin(), sIt2->cfunctions.end());
-                                    sIt2 = it->second.erase(sIt2);
-                                    sIt = sIt2;
-                                }else{
-                                    ++sIt2;
-                                }
-                            }
-                        }
+                    if(functionDepth && InControlHeader() && ctx.Nor({ParserState::exprstmt, ParserState::declstmt, ParserState::op})){
+                        ControlToken(ctx);
                     }
                 }
             };
+            closeEventMap[ParserState::archive] = [this](srcSAXEventContext&){
+                MergeProfiles(*profileMap);
+                if(lineIndex) lineIndex->Seal();
+            };
         }
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,205 @@
+/**
+ * @file srcslicewatch.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <profilestore.hpp>
+#ifdef __linux__
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <dirent.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#ifndef SRCSLICEWATCH
+#define SRCSLICEWATCH
+#ifdef __linux__
+/*
+ * inotify watches over every directory below a source root. Wait blocks until files
+ * are saved, moved in or deleted, then keeps collecting for a short quiet period so an
+ * editor's write-to-temp-and-rename save is reported as one change.
+ */
+class SourceWatcher{
+    public:
+        SourceWatcher(const std::string& root) : root(root), fd(inotify_init1(IN_CLOEXEC)){
+            if(fd >= 0) AddTree("");
+        }
+        ~SourceWatcher(){
+            if(fd >= 0) close(fd);
+        }
+        SourceWatcher(const SourceWatcher&) = delete;
+        SourceWatcher& operator=(const SourceWatcher&) = delete;
+
+        bool IsOpen() const{
+            return fd >= 0 && !directories.empty();
+        }
+        //Paths relative to the root that changed since the last call; empty only on error
+        std::set<std::string> Wait(){
+            std::set<std::string> changed;
+            const int QUIET_PERIOD_MS = 50;
+            while(changed.empty()){
+                if(!ReadEvents(changed)) return changed;
+                pollfd pending{fd, POLLIN, 0};
+                int ready;
+                while((ready = poll(&pending, 1, QUIET_PERIOD_MS)) > 0 || (ready < 0 && errno == EINTR)){
+                    if(ready > 0 && !ReadEvents(changed)) break;
+                }
+            }
+            return changed;
+        }
+    private:
+        std::string root;
+        int fd;
+        std::unordered_map<int, std::string> directories;
+
+        std::string FullPath(const std::string& relative) const{
+            return relative.empty() ? root : root + "/" + relative;
+        }
+        void AddTree(const std::string& relative){
+            int wd = inotify_add_watch(fd, FullPath(relative).c_str(),
+                                       IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE | IN_ONLYDIR);
+            if(wd < 0) return;
+            directories[wd] = relative;
+            DIR* dir = opendir(FullPath(relative).c_str());
+            if(!dir) return;
+            while(dirent* entry = readdir(dir)){
+                //skips ".", ".." and hidden directories such as .git
+                if(entry->d_name[0] == '.') continue;
+                std::string child = relative.empty() ? entry->d_name : relative + "/" + entry->d_name;
+                struct stat info;
+                if(stat(FullPath(child).c_str(), &info) == 0 && S_ISDIR(info.st_mode)) AddTree(child);
+            }
+            closedir(dir);
+        }
+        bool ReadEvents(std::set<std::string>& changed){
+            alignas(inotify_event) char buffer[64 * 1024];
+            ssize_t length;
+            //a signal arriving while blocked is not a failure of the watch
+            do{
+                length = read(fd, buffer, sizeof(buffer));
+            }while(length < 0 && errno == EINTR);
+            if(length <= 0) return false;
+            for(char* current = buffer; current < buffer + length; current += sizeof(inotify_event) + reinterpret_cast<inotify_event*>(current)->len){
+                const inotify_event* event = reinterpret_cast<inotify_event*>(current);
+                if(event->mask & IN_IGNORED){
+                    directories.erase(event->wd);
+                    continue;
+                }
+                auto directory = directories.find(event->wd);
+                if(directory == directories.end() || !event->len) continue;
+                std::string path = directory->second.empty() ? event->name : directory->second + "/" + event->name;
+                if(event->mask & IN_ISDIR){
+                    if(event->mask & (IN_CREATE | IN_MOVED_TO)) AddTree(path);
+                    continue;
+                }
+                //a bare IN_CREATE is followed by IN_CLOSE_WRITE once the file has content
+                if(event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE)) changed.insert(path);
+            }
+            return true;
+        }
+};
+
+//Extensions srcML can parse
+inline bool IsSliceableSource(const std::string& path){
+    static const char* const extensions[] = {".c", ".h", ".cpp", ".cc", ".cxx", ".hpp", ".hh", ".hxx", ".java", ".cs"};
+    for(const char* extension : extensions){
+        std::size_t size = std::strlen(extension);
+        if(path.size() > size && path.compare(path.size() - size, size, extension) == 0) return true;
+    }
+    return false;
+}
+
+//Runs the srcml client on one file below root; returns false if it fails
+inline bool RegenerateSrcML(const std::string& root, const std::string& relative, std::string& srcml){
+    auto quote = [](const std::string& argument){
+        std::string quoted = "'";
+        for(char ch : argument){
+            if(ch == '\'') quoted += "'\\''";
+            else quoted += ch;
+        }
+        return quoted + "'";
+    };
+    std::string command = "cd " + quote(root) + " && srcml --position " + quote(relative) + " 2>/dev/null";
+    FILE* pipe = popen(command.c_str(), "r");
+    if(!pipe) return false;
+    srcml.clear();
+    char buffer[64 * 1024];
+    std::size_t size;
+    while((size = fread(buffer, 1, sizeof(buffer), pipe)) > 0){
+        srcml.append(buffer, size);
+    }
+    return pclose(pipe) == 0 && !srcml.empty();
+}
+
+/*
+ * Keeps store in sync with the sources below root until the watch fails. Each changed
+ * file is re-run through srcml on its own and swapped into the store, so an update
+ * costs the edited file's size, not the project's. onUpdate gets the file's new
+ * profiles merged as in a batch run (see ProfileStore::Merged), or null once it has
+ * been deleted, then the same for every other unit declaring a global the file uses.
+ * Returns false if root cannot be watched.
+ */
+inline bool WatchAndReslice(ProfileStore& store, const std::string& root,
+                            std::function<void(const std::string&, const ProfileStore::ProfileMap*)> onUpdate){
+    SourceWatcher watcher(root);
+    if(!watcher.IsOpen()) return false;
+    //store keys for watched paths; the initial archive may spell them with a different prefix
+    std::unordered_map<std::string, std::string> keys;
+    for(std::set<std::string> changed = watcher.Wait(); !changed.empty(); changed = watcher.Wait()){
+        for(const std::string& relative : changed){
+            if(!IsSliceableSource(relative)) continue;
+            auto key = keys.find(relative);
+            if(key == keys.end()){
+                std::string stored = store.FindUnit(relative);
+                key = keys.insert(std::make_pair(relative, stored.empty() ? relative : stored)).first;
+            }
+            //the declarations this file's uses of globals fold into change along with it
+            std::unordered_set<std::string> declaring = store.DeclaringUnits(key->second);
+            struct stat info;
+            if(stat((root + "/" + relative).c_str(), &info) != 0){
+                store.Remove(key->second);
+                onUpdate(key->second, 0);
+            }else{
+                std::string srcml;
+                if(!RegenerateSrcML(root, relative, srcml)) continue;
+                store.Replace(key->second, srcml);
+                ProfileStore::ProfileMap profiles = store.Merged(key->second);
+                onUpdate(key->second, &profiles);
+                std::unordered_set<std::string> nowDeclaring = store.DeclaringUnits(key->second);
+                declaring.insert(nowDeclaring.begin(), nowDeclaring.end());
+            }
+            declaring.erase(key->second);
+            for(const std::string& file : declaring){
+                if(!store.Unit(file)) continue;
+                ProfileStore::ProfileMap profiles = store.Merged(file);
+                onUpdate(file, &profiles);
+            }
+        }
+    }
+    return false;
+}
+#endif
+#endif
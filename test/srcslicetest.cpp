@@ -4,7 +4,12 @@
 #include <libxml/parser.h>
 #include <libxml/xpath.h>
 #include <libxml/xpathInternals.h>
-#include <srcslicepolicy.hpp>
+#include <srcsliceparallel.hpp>
+#include <srcslicepipeline.hpp>
+#include <slicesource.hpp>
+#include <changeimpact.hpp>
+#include <profilestore.hpp>
+#include <srcslice.h>
 
 std::string StringToSrcML(std::string str){
     struct srcml_archive* archive;
@@ -33,6 +38,34 @@ std::string StringToSrcML(std::string str){
     return std::string(ch);
 }
 
+//An archive with one unit per (filename, source) pair
+std::string UnitsToSrcML(const std::vector<std::pair<std::string, std::string>>& sources){
+    struct srcml_archive* archive;
+    size_t size = 0;
+
+    char *ch = 0;
+
+    archive = srcml_archive_create();
+    srcml_archive_enable_option(archive, SRCML_OPTION_POSITION | SRCML_OPTION_ARCHIVE);
+    srcml_archive_write_open_memory(archive, &ch, &size);
+
+    for(const auto& source : sources){
+        struct srcml_unit* unit = srcml_unit_create(archive);
+        srcml_unit_set_language(unit, SRCML_LANGUAGE_CXX);
+        srcml_unit_set_filename(unit, source.first.c_str());
+
+        srcml_unit_parse_memory(unit, source.second.c_str(), source.second.size());
+        srcml_archive_write_unit(archive, unit);
+        srcml_unit_free(unit);
+    }
+    srcml_archive_close(archive);
+    srcml_archive_free(archive);
+
+    ch[size-1] = 0;
+    
+    return std::string(ch);
+}
+
 namespace {
   class TestsrcSliceDeclPolicy : public ::testing::Test{
   public:
@@ -409,4 +442,810 @@ TEST_F(TestParamSliceDetection, TestParamsL) {
     
     EXPECT_TRUE(exprIt->second.back().definitions.find(LINE_NUM_DEF_OF_L) != exprIt->second.back().definitions.end());
     EXPECT_TRUE(exprIt->second.back().definitions.find(LINE_NUM_SECOND_DEF_OF_L) != exprIt->second.back().definitions.end());
-}
\ No newline at end of file
+}
+namespace {
+  class TestsrcSliceCInterface : public ::testing::Test{
+  public:
+    srcslice_archive* archive;
+    TestsrcSliceCInterface(){
+
+    }
+    void SetUp(){
+      std::string str = 
+      "int main(){\n"
+      "Object b = 5;\n"
+      "const Object ke_e4e = b;\n"
+      "Foo(ke_e4e);\n"
+      "}\n";
+      std::string srcmlStr = StringToSrcML(str);
+
+      archive = srcslice_create();
+      srcslice_parse_memory(archive, srcmlStr.c_str(), srcmlStr.size());
+    }
+    void TearDown(){
+      srcslice_free(archive);
+    }
+    ~TestsrcSliceCInterface(){
+
+    }
+  };
+}
+
+TEST_F(TestsrcSliceCInterface, TestProfileLookup) {
+    const unsigned int LINE_NUM_DEF_OF_B = 2;
+    const unsigned int LINE_NUM_USE_OF_B = 3;
+    const srcslice_profile* profileOfB = 0;
+    for(size_t i = 0; i < srcslice_profile_count(archive); ++i){
+        const srcslice_profile* profile = srcslice_get_profile(archive, i);
+        if(std::string(srcslice_profile_name(profile)) == "b" && srcslice_profile_contains_declaration(profile)){
+            profileOfB = profile;
+        }
+    }
+    ASSERT_TRUE(profileOfB != 0);
+
+    const unsigned int* lines = 0;
+    size_t numDefs = srcslice_profile_definitions(profileOfB, &lines);
+    EXPECT_TRUE(std::find(lines, lines + numDefs, LINE_NUM_DEF_OF_B) != lines + numDefs);
+    size_t numUses = srcslice_profile_uses(profileOfB, &lines);
+    EXPECT_TRUE(std::find(lines, lines + numUses, LINE_NUM_USE_OF_B) != lines + numUses);
+
+    ASSERT_EQ(srcslice_profile_dvar_count(profileOfB), 1);
+    EXPECT_EQ(std::string(srcslice_profile_dvar(profileOfB, 0)), "ke_e4e");
+}
+
+TEST_F(TestsrcSliceCInterface, TestInvalidArguments) {
+    EXPECT_EQ(srcslice_parse_memory(0, "", 0), SRCSLICE_STATUS_INVALID_ARGUMENT);
+    EXPECT_EQ(srcslice_parse_filename(archive, 0), SRCSLICE_STATUS_INVALID_ARGUMENT);
+    EXPECT_TRUE(srcslice_get_profile(archive, srcslice_profile_count(archive)) == 0);
+}
+
+namespace {
+  class TestsrcSliceChangeImpact : public ::testing::Test{
+  public:
+    std::unordered_map<std::string, std::vector<SliceProfile>> profileMap;
+    ChangeImpact changeImpact;
+    LineIndex lineIndex;
+    TestsrcSliceChangeImpact(){
+
+    }
+    void SetUp(){
+      std::string str = 
+      "int main(){\n"
+      "Object b = 5;\n"
+      "const Object ke_e4e = b;\n"
+      "Object z = 7;\n"
+      "coo = ke_e4e + 1;\n"
+      "}\n";
+      std::string srcmlStr = StringToSrcML(str);
+
+      changeImpact.AddRange("testsrcType.cpp:2");
+      SrcSlicePolicy* cat = new SrcSlicePolicy(&profileMap);
+      cat->SetLineIndex(&lineIndex);
+      cat->SetChangeImpact(&changeImpact);
+      srcSAXController control(srcmlStr);
+      srcSAXEventDispatch::srcSAXEventDispatcher<> handler({cat});
+      control.parse(&handler);
+    }
+    void TearDown(){
+
+    }
+    ~TestsrcSliceChangeImpact(){
+
+    }
+  };
+}
+
+TEST_F(TestsrcSliceChangeImpact, TestRangeParsing) {
+    ChangeImpact ranges;
+    EXPECT_TRUE(ranges.AddRange("src/foo.cpp:10-20"));
+    EXPECT_FALSE(ranges.AddRange("src/foo.cpp"));
+    EXPECT_FALSE(ranges.AddRange("src/foo.cpp:20-10"));
+    EXPECT_TRUE(ranges.Contains("src/foo.cpp", 15));
+    EXPECT_TRUE(ranges.Contains("./src/foo.cpp", 10));
+    EXPECT_TRUE(ranges.Contains("project/src/foo.cpp", 20));
+    EXPECT_FALSE(ranges.Contains("src/foo.cpp", 21));
+    EXPECT_FALSE(ranges.Contains("src/bar.cpp", 15));
+}
+
+std::unordered_set<std::string> AffectedNames(const std::vector<const SliceProfile*>& profiles){
+    std::unordered_set<std::string> names;
+    for(const SliceProfile* profile : profiles){
+        names.insert(profile->variableName);
+    }
+    return names;
+}
+
+TEST_F(TestsrcSliceChangeImpact, TestForwardSliceFromChangedLine) {
+    std::unordered_set<std::string> affected = AffectedNames(changeImpact.ForwardSlice(profileMap));
+
+    EXPECT_TRUE(affected.find("b") != affected.end());
+    EXPECT_TRUE(affected.find("ke_e4e") != affected.end());
+    EXPECT_TRUE(affected.find("coo") != affected.end());
+    EXPECT_TRUE(affected.find("z") == affected.end());
+}
+
+TEST(TestsrcSliceChangeImpactScope, TestLikeNamedVariablesNotPulledIn) {
+    std::string str = 
+    "void f(){\n"
+    "int i = 1;\n"
+    "int a = i;\n"
+    "}\n"
+    "void g(){\n"
+    "int i = 2;\n"
+    "int c = i;\n"
+    "}\n";
+    std::unordered_map<std::string, std::vector<SliceProfile>> profileMap;
+    ChangeImpact changeImpact;
+    changeImpact.AddRange("testsrcType.cpp:2");
+    SrcSlicePolicy* cat = new SrcSlicePolicy(&profileMap);
+    cat->SetChangeImpact(&changeImpact);
+    srcSAXController control(StringToSrcML(str));
+    SrcSliceEventDispatcher<> handler({cat});
+    control.parse(&handler);
+
+    std::vector<const SliceProfile*> affected = changeImpact.ForwardSlice(profileMap);
+    std::unordered_set<std::string> names = AffectedNames(affected);
+
+    EXPECT_TRUE(names.find("i") != names.end());
+    EXPECT_TRUE(names.find("a") != names.end());
+    EXPECT_TRUE(names.find("c") == names.end());
+    for(const SliceProfile* profile : affected){
+        if(profile->variableName == "i"){
+            EXPECT_EQ(profile->lineNumber, 2);
+        }
+    }
+}
+
+TEST(TestsrcSliceChangeImpactScope, TestGlobalAssignedInAnotherFile) {
+    std::unordered_map<std::string, std::vector<SliceProfile>> profileMap;
+    ChangeImpact changeImpact;
+    changeImpact.AddRange("bar.cpp:2");
+    SrcSlicePolicy* cat = new SrcSlicePolicy(&profileMap);
+    cat->SetChangeImpact(&changeImpact);
+    srcSAXController control(UnitsToSrcML({
+        {"foo.cpp", "int g = 0;\nint h = g;\n"},
+        {"bar.cpp", "void set(){\ng = 5;\n}\n"}}));
+    SrcSliceEventDispatcher<> handler({cat});
+    control.parse(&handler);
+
+    std::vector<const SliceProfile*> affected = changeImpact.ForwardSlice(profileMap);
+    std::unordered_set<std::string> names = AffectedNames(affected);
+
+    EXPECT_TRUE(names.find("g") != names.end());
+    EXPECT_TRUE(names.find("h") != names.end());
+    for(const SliceProfile* profile : affected){
+        if(profile->variableName == "g"){
+            EXPECT_EQ(profile->file, "foo.cpp");
+        }
+    }
+}
+
+TEST_F(TestsrcSliceChangeImpact, TestOnlyChangedDefinitionsKept) {
+    EXPECT_EQ(changeImpact.ChangedDefinitions(), (std::unordered_set<std::string>{"b"}));
+}
+
+TEST_F(TestsrcSliceChangeImpact, TestLineIndexQueries) {
+    const int LINE_NUM_DECL_OF_KE_E4E = 3;
+    std::vector<std::string> anyKind = lineIndex.Query("testsrcType.cpp", LINE_NUM_DECL_OF_KE_E4E);
+    std::vector<std::string> definitions = lineIndex.Query("testsrcType.cpp", LINE_NUM_DECL_OF_KE_E4E, LineIndex::DEFINITION);
+
+    EXPECT_TRUE(std::find(anyKind.begin(), anyKind.end(), "b") != anyKind.end());
+    EXPECT_TRUE(std::find(anyKind.begin(), anyKind.end(), "ke_e4e") != anyKind.end());
+    EXPECT_TRUE(std::find(definitions.begin(), definitions.end(), "ke_e4e") != definitions.end());
+    EXPECT_TRUE(std::find(definitions.begin(), definitions.end(), "b") == definitions.end());
+}
+
+TEST(TestLineIndex, TestIncrementalSealedLookup) {
+    LineIndex index;
+    index.Record("src/foo.cpp", 10, "a", LineIndex::DEFINITION);
+    index.Record("src/foo.cpp", 10, "a", LineIndex::USE);
+    index.Record("src/foo.cpp", 12, "b", LineIndex::USE);
+    index.Record("src/bar.cpp", 10, "c", LineIndex::DEFINITION);
+    index.Seal();
+
+    EXPECT_EQ(index.NumLines(), 3);
+    EXPECT_EQ(index.Query("src/foo.cpp", 10), std::vector<std::string>{"a"});
+    EXPECT_EQ(index.Query("foo.cpp", 10, 12), (std::vector<std::string>{"a", "b"}));
+    EXPECT_EQ(index.Query("./src/foo.cpp", 12), std::vector<std::string>{"b"});
+    EXPECT_EQ(index.Query("project/src/foo.cpp", 12, LineIndex::DEFINITION), std::vector<std::string>{});
+    EXPECT_EQ(index.Query("src/bar.cpp", 10), std::vector<std::string>{"c"});
+    EXPECT_TRUE(index.Query("src/foo.cpp", 11).empty());
+
+    index.Record("src/foo.cpp", 11, "d", LineIndex::DEFINITION);
+    EXPECT_TRUE(index.Query("src/foo.cpp", 11).empty());
+    index.Seal();
+    EXPECT_EQ(index.Query("src/foo.cpp", 11), std::vector<std::string>{"d"});
+    EXPECT_EQ(index.Query("src/foo.cpp", 10, 12), (std::vector<std::string>{"a", "b", "d"}));
+}
+
+namespace {
+  class TestsrcSliceDefUseChains : public ::testing::Test{
+  public:
+    std::unordered_map<std::string, std::vector<SliceProfile>> profileMap;
+    std::vector<DefUseChain> chains;
+    TestsrcSliceDefUseChains(){
+
+    }
+    void SetUp(){
+      std::string str = 
+      "int main(int k){\n"
+      "int a = k;\n"
+      "if(k){\n"
+      "a = 2;\n"
+      "}\n"
+      "b = a;\n"
+      "c = 1;\n"
+      "c = 2;\n"
+      "d = c;\n"
+      "if(c){\n"
+      "e = 1;\n"
+      "}else{\n"
+      "e = 2;\n"
+      "}\n"
+      "f = e;\n"
+      "for(int i = 0;\n"
+      "i < c;\n"
+      "i++){\n"
+      "g = i;\n"
+      "}\n"
+      "while((h = next()) > 0){\n"
+      "h = 0;\n"
+      "}\n"
+      "m = h;\n"
+      "do{\n"
+      "p = q;\n"
+      "q = m;\n"
+      "}while(p);\n"
+      "}\n";
+      std::string srcmlStr = StringToSrcML(str);
+
+      SrcSlicePolicy* cat = new SrcSlicePolicy(&profileMap);
+      cat->EnableDefUseChains(true);
+      srcSAXController control(srcmlStr);
+      srcSAXEventDispatch::srcSAXEventDispatcher<> handler({cat});
+      control.parse(&handler);
+      chains = cat->DefUseChains();
+    }
+    bool HasChain(std::string name, unsigned int def, unsigned int use){
+      for(const DefUseChain& chain : chains){
+        if(chain.variableName == name && chain.definitionLine == def && chain.useLine == use) return true;
+      }
+      return false;
+    }
+    void TearDown(){
+
+    }
+    ~TestsrcSliceDefUseChains(){
+
+    }
+  };
+}
+
+TEST_F(TestsrcSliceDefUseChains, TestParameterReachesUse) {
+    EXPECT_TRUE(HasChain("k", 1, 2));
+}
+
+TEST_F(TestsrcSliceDefUseChains, TestBranchDefinitionsBothReach) {
+    EXPECT_TRUE(HasChain("a", 2, 6));
+    EXPECT_TRUE(HasChain("a", 4, 6));
+}
+
+TEST_F(TestsrcSliceDefUseChains, TestKilledDefinitionDoesNotReach) {
+    EXPECT_TRUE(HasChain("c", 8, 9));
+    EXPECT_FALSE(HasChain("c", 7, 9));
+}
+
+TEST_F(TestsrcSliceDefUseChains, TestConditionUsesAreTracked) {
+    EXPECT_TRUE(HasChain("k", 1, 3));
+    EXPECT_TRUE(HasChain("c", 8, 10));
+}
+
+TEST_F(TestsrcSliceDefUseChains, TestIfElseArmsBothReach) {
+    EXPECT_TRUE(HasChain("e", 11, 15));
+    EXPECT_TRUE(HasChain("e", 13, 15));
+}
+
+TEST_F(TestsrcSliceDefUseChains, TestForInductionVariable) {
+    EXPECT_TRUE(HasChain("i", 16, 17));
+    EXPECT_TRUE(HasChain("i", 16, 19));
+    EXPECT_TRUE(HasChain("i", 16, 18));
+    EXPECT_TRUE(HasChain("i", 18, 17));
+    EXPECT_TRUE(HasChain("i", 18, 19));
+    EXPECT_TRUE(HasChain("c", 8, 17));
+}
+
+TEST_F(TestsrcSliceDefUseChains, TestLoopExitsFromCondition) {
+    EXPECT_TRUE(HasChain("h", 21, 24));
+    EXPECT_FALSE(HasChain("h", 22, 24));
+}
+
+TEST_F(TestsrcSliceDefUseChains, TestDoWhileBackEdge) {
+    EXPECT_TRUE(HasChain("q", 27, 26));
+    EXPECT_TRUE(HasChain("m", 24, 27));
+    EXPECT_TRUE(HasChain("p", 26, 28));
+}
+
+TEST(TestBitVector, TestWordParallelOperations) {
+    BitVector lhs(130), rhs(130);
+    lhs.Set(1); lhs.Set(64); lhs.Set(129);
+    rhs.Set(64); rhs.Set(100);
+
+    BitVector unionSet = lhs;
+    unionSet.UnionWith(rhs);
+    EXPECT_TRUE(unionSet.Test(1) && unionSet.Test(64) && unionSet.Test(100) && unionSet.Test(129));
+
+    BitVector intersection = lhs;
+    intersection.IntersectWith(rhs);
+    EXPECT_TRUE(intersection.Test(64));
+    EXPECT_FALSE(intersection.Test(1) || intersection.Test(100) || intersection.Test(129));
+
+    lhs.Subtract(rhs);
+    EXPECT_FALSE(lhs.Test(64));
+    EXPECT_TRUE(lhs.Test(1) && lhs.Test(129));
+}
+
+namespace {
+  class TestsrcSliceSkippedElements : public ::testing::Test{
+  public:
+    std::unordered_map<std::string, std::vector<SliceProfile>> profileMap;
+    TestsrcSliceSkippedElements(){
+
+    }
+    void SetUp(){
+      std::string str = 
+      "#define LIMIT 5\n"
+      "int main(){\n"
+      "// b is the counter\n"
+      "static Object b = 5;\n"
+      "std::vector<Widget> ke_e4e = b; /* copy */\n"
+      "#ifdef DEBUG\n"
+      "caa34 = b + 1;\n"
+      "#endif\n"
+      "}\n";
+      std::string srcmlStr = StringToSrcML(str);
+
+      SrcSlicePolicy* cat = new SrcSlicePolicy(&profileMap);
+      srcSAXController control(srcmlStr);
+      SrcSliceEventDispatcher<> handler({cat});
+      control.parse(&handler);
+    }
+    void TearDown(){
+
+    }
+    ~TestsrcSliceSkippedElements(){
+
+    }
+  };
+}
+
+TEST_F(TestsrcSliceSkippedElements, TestSlicingUnaffectedBySkippedSubtrees) {
+    const int LINE_NUM_DEF_OF_B = 4;
+    const int FIRST_LINE_NUM_USE_OF_B = 5;
+    const int SECOND_LINE_NUM_USE_OF_B = 7;
+    auto exprIt = profileMap.find("b");
+
+    ASSERT_TRUE(exprIt != profileMap.end());
+    EXPECT_TRUE(exprIt->second.back().definitions.find(LINE_NUM_DEF_OF_B) != exprIt->second.back().definitions.end());
+    EXPECT_TRUE(exprIt->second.back().uses.find(FIRST_LINE_NUM_USE_OF_B) != exprIt->second.back().uses.end());
+    EXPECT_TRUE(exprIt->second.back().uses.find(SECOND_LINE_NUM_USE_OF_B) != exprIt->second.back().uses.end());
+    EXPECT_TRUE(exprIt->second.back().dvars.find("ke_e4e") != exprIt->second.back().dvars.end());
+}
+
+TEST_F(TestsrcSliceSkippedElements, TestSkippedSubtreesProduceNoProfiles) {
+    EXPECT_TRUE(profileMap.find("LIMIT") == profileMap.end());
+    EXPECT_TRUE(profileMap.find("DEBUG") == profileMap.end());
+    EXPECT_TRUE(profileMap.find("Widget") == profileMap.end());
+}
+
+namespace {
+  class TestsrcSliceParallelRegions : public ::testing::Test{
+  public:
+    std::unordered_map<std::string, std::vector<SliceProfile>> profileMap;
+    std::vector<std::string> regions;
+    TestsrcSliceParallelRegions(){
+
+    }
+    void SetUp(){
+      std::string str = 
+      "int g = 0;\n"
+      "void foo(){\n"
+      "int a = g;\n"
+      "}\n"
+      "void bar(){\n"
+      "g = 5;\n"
+      "}\n"
+      "int* gp;\n"
+      "void baz(){\n"
+      "int x = 1;\n"
+      "gp = x;\n"
+      "}\n";
+      std::string srcmlStr = StringToSrcML(str);
+
+      const int SPLIT_AT_EVERY_FUNCTION = 1;
+      const int NUM_THREADS = 2;
+      regions = SrcMLRegionSplitter(srcmlStr).Split(SPLIT_AT_EVERY_FUNCTION);
+      ParallelSlice(regions, profileMap, NUM_THREADS);
+    }
+    void TearDown(){
+
+    }
+    ~TestsrcSliceParallelRegions(){
+
+    }
+  };
+}
+
+TEST_F(TestsrcSliceParallelRegions, TestSplitAtTopLevelBoundaries) {
+    const int NUM_TOP_LEVEL_ELEMENTS = 3;
+    EXPECT_GE(regions.size(), NUM_TOP_LEVEL_ELEMENTS);
+}
+
+TEST_F(TestsrcSliceParallelRegions, TestGlobalResolvedAcrossRegions) {
+    const int LINE_NUM_DECL_DEF_OF_G = 1;
+    const int LINE_NUM_USE_OF_G = 3;
+    const int LINE_NUM_EXPR_DEF_OF_G = 6;
+    auto exprIt = profileMap.find("g");
+
+    ASSERT_TRUE(exprIt != profileMap.end());
+    ASSERT_EQ(exprIt->second.size(), 1);
+    EXPECT_TRUE(exprIt->second.back().containsDeclaration);
+    EXPECT_TRUE(exprIt->second.back().definitions.find(LINE_NUM_DECL_DEF_OF_G) != exprIt->second.back().definitions.end());
+    EXPECT_TRUE(exprIt->second.back().definitions.find(LINE_NUM_EXPR_DEF_OF_G) != exprIt->second.back().definitions.end());
+    EXPECT_TRUE(exprIt->second.back().uses.find(LINE_NUM_USE_OF_G) != exprIt->second.back().uses.end());
+    EXPECT_TRUE(exprIt->second.back().dvars.find("a") != exprIt->second.back().dvars.end());
+}
+
+TEST_F(TestsrcSliceParallelRegions, TestGlobalPointerAliasedAcrossRegions) {
+    auto exprIt = profileMap.find("x");
+
+    ASSERT_TRUE(exprIt != profileMap.end());
+    EXPECT_TRUE(exprIt->second.back().aliases.find("gp") != exprIt->second.back().aliases.end());
+    EXPECT_TRUE(exprIt->second.back().dvars.find("gp") == exprIt->second.back().dvars.end());
+}
+
+namespace {
+  class TestsrcSliceSourceExtraction : public ::testing::Test{
+  public:
+    std::string sourcePath;
+    std::string terminatedSourcePath;
+    TestsrcSliceSourceExtraction(){
+
+    }
+    void SetUp(){
+      sourcePath = WriteTemporarySource(
+      "int main(){\n"
+      "Object b = 5;\r\n"
+      "const Object ke_e4e = b;\n"
+      "return b;");
+      terminatedSourcePath = WriteTemporarySource(
+      "int main(){\r\n"
+      "return 0;\r\n");
+    }
+    void TearDown(){
+      unlink(sourcePath.c_str());
+      unlink(terminatedSourcePath.c_str());
+    }
+    ~TestsrcSliceSourceExtraction(){
+
+    }
+    static std::string WriteTemporarySource(const std::string& source){
+      char path[] = "/tmp/srcslicesourceXXXXXX";
+      int fd = mkstemp(path);
+      EXPECT_GE(fd, 0);
+      EXPECT_EQ(write(fd, source.c_str(), source.size()), (ssize_t)source.size());
+      close(fd);
+      return path;
+    }
+  };
+}
+
+TEST_F(TestsrcSliceSourceExtraction, TestLineTable) {
+    const int NUM_LINES = 4;
+    MappedSource source(sourcePath);
+
+    ASSERT_TRUE(source.IsOpen());
+    EXPECT_EQ(source.NumLines(), NUM_LINES);
+    EXPECT_EQ(source.Line(2).str(), "Object b = 5;");
+    EXPECT_EQ(source.Line(4).str(), "return b;");
+    EXPECT_EQ(source.Line(5).size, 0);
+}
+
+TEST_F(TestsrcSliceSourceExtraction, TestNewlineTerminatedLastLine) {
+    const int NUM_LINES = 2;
+    MappedSource source(terminatedSourcePath);
+
+    ASSERT_TRUE(source.IsOpen());
+    EXPECT_EQ(source.NumLines(), NUM_LINES);
+    EXPECT_EQ(source.Line(1).str(), "int main(){");
+    EXPECT_EQ(source.Line(2).str(), "return 0;");
+}
+
+TEST_F(TestsrcSliceSourceExtraction, TestExtractSliceLines) {
+    SliceProfile profile("b", 2, false, false, std::set<unsigned int>{2}, std::set<unsigned int>{3, 4});
+    profile.file = sourcePath;
+    SliceSourceExtractor extractor;
+    auto lines = extractor.Extract(profile);
+
+    ASSERT_EQ(lines.size(), 3);
+    EXPECT_EQ(lines[0].first, 2);
+    EXPECT_EQ(lines[1].second.str(), "const Object ke_e4e = b;");
+    EXPECT_EQ(extractor.Source(sourcePath), extractor.Source(sourcePath));
+    EXPECT_TRUE(extractor.Source("/nonexistent/file.cpp") == 0);
+}
+
+TEST_F(TestsrcSliceSourceExtraction, TestLinesFromOtherFilesSkipped) {
+    const int LINE_NUM_USE_IN_OTHER_FILE = 4;
+    SliceProfile profile("b", 2, false, false, std::set<unsigned int>{2}, std::set<unsigned int>{3, LINE_NUM_USE_IN_OTHER_FILE});
+    profile.file = sourcePath;
+    LineIndex recorded;
+    recorded.Record(sourcePath, 2, "b", LineIndex::DEFINITION);
+    recorded.Record(sourcePath, 3, "b", LineIndex::USE);
+    recorded.Record("other.cpp", LINE_NUM_USE_IN_OTHER_FILE, "b", LineIndex::USE);
+    recorded.Seal();
+    SliceSourceExtractor extractor;
+    auto lines = extractor.Extract(profile, &recorded);
+
+    ASSERT_EQ(lines.size(), 2);
+    EXPECT_EQ(lines[0].first, 2);
+    EXPECT_EQ(lines[1].first, 3);
+}
+
+TEST(TestAliasClasses, TestUnionFindClasses) {
+    std::shared_ptr<AliasClasses> classes = std::make_shared<AliasClasses>();
+    AliasSet aliasesOfA, aliasesOfC;
+    aliasesOfA.Attach(classes, "a");
+    aliasesOfC.Attach(classes, "c");
+
+    aliasesOfA.insert("b");
+    EXPECT_TRUE(aliasesOfC.empty());
+    aliasesOfC.insert("b");
+
+    const int NUM_OTHER_MEMBERS = 2;
+    EXPECT_EQ(aliasesOfA.size(), NUM_OTHER_MEMBERS);
+    EXPECT_TRUE(aliasesOfA.find("c") != aliasesOfA.end());
+    EXPECT_TRUE(aliasesOfA.find("a") == aliasesOfA.end());
+    EXPECT_TRUE(aliasesOfA.find("d") == aliasesOfA.end());
+
+    std::set<std::string> members(aliasesOfC.begin(), aliasesOfC.end());
+    EXPECT_EQ(members, (std::set<std::string>{"a", "b"}));
+}
+
+TEST(TestAliasClasses, TestRepeatedNamesListedOnce) {
+    std::shared_ptr<AliasClasses> classes = std::make_shared<AliasClasses>();
+    AliasSet aliasesOfA, aliasesOfB, aliasesOfOtherA;
+    aliasesOfA.Attach(classes, "a");
+    aliasesOfB.Attach(classes, "b");
+    aliasesOfOtherA.Attach(classes, "a");
+    aliasesOfB.insert("a");
+    aliasesOfA.insert("b");
+
+    std::multiset<std::string> members(aliasesOfB.begin(), aliasesOfB.end());
+    EXPECT_EQ(members, std::multiset<std::string>{"a"});
+    EXPECT_EQ(aliasesOfB.size(), 1);
+    EXPECT_EQ(aliasesOfA.size(), 1);
+    EXPECT_TRUE(aliasesOfA.find("a") == aliasesOfA.end());
+}
+
+TEST_F(TestsrcSliceAliasDetection, TestAliasClassesAreShared) {
+    auto exprIt = profileMap.find("b");
+
+    EXPECT_TRUE(exprIt->second.back().aliases.find("ke_e4e") != exprIt->second.back().aliases.end());
+    EXPECT_TRUE(exprIt->second.back().aliases.find("e") != exprIt->second.back().aliases.end());
+}
+
+namespace {
+  class TestsrcSliceAliasScope : public ::testing::Test{
+  public:
+    std::unordered_map<std::string, std::vector<SliceProfile>> profileMap;
+    TestsrcSliceAliasScope(){
+
+    }
+    void SetUp(){
+      std::string str = 
+      "void f(){\n"
+      "int x = 1;\n"
+      "int* p = &x;\n"
+      "}\n"
+      "void g(){\n"
+      "int y = 2;\n"
+      "int* p = &y;\n"
+      "}\n";
+      std::string srcmlStr = StringToSrcML(str);
+    
+      SrcSlicePolicy* cat = new SrcSlicePolicy(&profileMap);
+      srcSAXController control(srcmlStr);
+      srcSAXEventDispatch::srcSAXEventDispatcher<> handler({cat});
+      control.parse(&handler);
+    }
+    void TearDown(){
+
+    }
+    ~TestsrcSliceAliasScope(){
+
+    }
+  };
+}
+
+TEST_F(TestsrcSliceAliasScope, TestReusedPointerNamesStaySeparate) {
+    auto xIt = profileMap.find("x");
+    auto yIt = profileMap.find("y");
+
+    ASSERT_TRUE(xIt != profileMap.end());
+    ASSERT_TRUE(yIt != profileMap.end());
+    EXPECT_TRUE(xIt->second.back().aliases.find("p") != xIt->second.back().aliases.end());
+    EXPECT_TRUE(yIt->second.back().aliases.find("p") != yIt->second.back().aliases.end());
+    EXPECT_TRUE(xIt->second.back().aliases.find("y") == xIt->second.back().aliases.end());
+    EXPECT_TRUE(yIt->second.back().aliases.find("x") == yIt->second.back().aliases.end());
+}
+
+namespace {
+  class TestsrcSlicePipeline : public ::testing::Test{
+  public:
+    std::unordered_map<std::string, std::vector<SliceProfile>> serialProfileMap;
+    std::unordered_map<std::string, std::vector<SliceProfile>> pipelinedProfileMap;
+    TestsrcSlicePipeline(){
+
+    }
+    void SetUp(){
+      std::string str = 
+      "int g = 0;\n"
+      "// g is shared\n"
+      "int main(){\n"
+      "Object b = 5;\n"
+      "Object* c = &b;\n"
+      "const Object ke_e4e = b + g;\n"
+      "foo(b, ke_e4e);\n"
+      "return b;\n"
+      "}\n";
+      std::string srcmlStr = StringToSrcML(str);
+
+      SrcSlicePolicy* serial = new SrcSlicePolicy(&serialProfileMap);
+      srcSAXController serialControl(srcmlStr);
+      SrcSliceEventDispatcher<> serialHandler({serial});
+      serialControl.parse(&serialHandler);
+
+      SrcSlicePolicy* pipelined = new SrcSlicePolicy(&pipelinedProfileMap);
+      srcSAXController pipelinedControl(srcmlStr);
+      SrcSliceEventDispatcher<> pipelinedHandler({pipelined});
+      PipelinedParse(pipelinedControl, pipelinedHandler);
+    }
+    void TearDown(){
+
+    }
+    ~TestsrcSlicePipeline(){
+
+    }
+  };
+}
+
+TEST_F(TestsrcSlicePipeline, TestPipelinedMatchesSerial) {
+    ASSERT_EQ(pipelinedProfileMap.size(), serialProfileMap.size());
+    for(const auto& entry : serialProfileMap){
+        auto pipelinedIt = pipelinedProfileMap.find(entry.first);
+
+        ASSERT_TRUE(pipelinedIt != pipelinedProfileMap.end());
+        ASSERT_EQ(pipelinedIt->second.size(), entry.second.size());
+        for(std::size_t i = 0; i < entry.second.size(); ++i){
+            EXPECT_EQ(pipelinedIt->second[i].definitions, entry.second[i].definitions);
+            EXPECT_EQ(pipelinedIt->second[i].uses, entry.second[i].uses);
+            EXPECT_EQ(pipelinedIt->second[i].dvars, entry.second[i].dvars);
+            EXPECT_EQ(pipelinedIt->second[i].file, entry.second[i].file);
+            EXPECT_EQ(pipelinedIt->second[i].containsDeclaration, entry.second[i].containsDeclaration);
+        }
+    }
+}
+
+TEST_F(TestsrcSlicePipeline, TestPipelinedRecordsLineNumbers) {
+    const int LINE_NUM_DEF_OF_B = 4;
+    const int LINE_NUM_USE_OF_B = 6;
+    auto exprIt = pipelinedProfileMap.find("b");
+
+    ASSERT_TRUE(exprIt != pipelinedProfileMap.end());
+    EXPECT_TRUE(exprIt->second.back().definitions.find(LINE_NUM_DEF_OF_B) != exprIt->second.back().definitions.end());
+    EXPECT_TRUE(exprIt->second.back().uses.find(LINE_NUM_USE_OF_B) != exprIt->second.back().uses.end());
+    EXPECT_EQ(exprIt->second.back().file, "testsrcType.cpp");
+}
+
+namespace {
+  class TestsrcSliceProfileStore : public ::testing::Test{
+  public:
+    ProfileStore store;
+    std::size_t numUnits;
+    TestsrcSliceProfileStore(){
+
+    }
+    void SetUp(){
+      std::string str = 
+      "int main(){\n"
+      "Object b = 5;\n"
+      "const Object ke_e4e = b;\n"
+      "}\n";
+      numUnits = store.Load(StringToSrcML(str));
+    }
+    void TearDown(){
+
+    }
+    ~TestsrcSliceProfileStore(){
+
+    }
+  };
+}
+
+TEST_F(TestsrcSliceProfileStore, TestLoadSlicesEveryUnit) {
+    const int LINE_NUM_DEF_OF_B = 2;
+    std::vector<const SliceProfile*> profiles = store.Profiles("b");
+
+    EXPECT_EQ(numUnits, 1);
+    ASSERT_TRUE(store.Unit("testsrcType.cpp") != 0);
+    ASSERT_EQ(profiles.size(), 1);
+    EXPECT_TRUE(profiles.back()->definitions.find(LINE_NUM_DEF_OF_B) != profiles.back()->definitions.end());
+    EXPECT_EQ(store.FindUnit("src/testsrcType.cpp"), "testsrcType.cpp");
+}
+
+TEST_F(TestsrcSliceProfileStore, TestReplaceRetractsOldContributions) {
+    const int LINE_NUM_DEF_OF_C = 3;
+    std::string str = 
+    "int main(){\n"
+    "\n"
+    "Object c = 5;\n"
+    "}\n";
+    store.Replace("testsrcType.cpp", StringToSrcML(str));
+    std::vector<const SliceProfile*> profiles = store.Profiles("c");
+
+    EXPECT_EQ(store.NumUnits(), 1);
+    EXPECT_TRUE(store.Profiles("b").empty());
+    EXPECT_TRUE(store.Profiles("ke_e4e").empty());
+    ASSERT_EQ(profiles.size(), 1);
+    EXPECT_TRUE(profiles.back()->definitions.find(LINE_NUM_DEF_OF_C) != profiles.back()->definitions.end());
+
+    store.Remove("testsrcType.cpp");
+    EXPECT_EQ(store.NumUnits(), 0);
+    EXPECT_TRUE(store.Profiles("c").empty());
+}
+
+TEST(TestsrcSliceProfileStoreMerge, TestGlobalUsesFoldedAcrossUnits) {
+    const int LINE_NUM_DECL_DEF_OF_G = 1;
+    const int LINE_NUM_DEF_OF_G_IN_BAR = 2;
+    const int LINE_NUM_DEF_OF_G_IN_NEW_BAR = 3;
+    ProfileStore store;
+    store.Load(UnitsToSrcML({
+        {"foo.cpp", "int g = 0;\n"},
+        {"bar.cpp", "void set(){\ng = 5;\n}\n"}}));
+
+    ProfileStore::ProfileMap merged = store.Merged("foo.cpp");
+    ASSERT_EQ(merged["g"].size(), 1);
+    EXPECT_EQ(merged["g"].back().definitions, (std::set<unsigned int>{LINE_NUM_DECL_DEF_OF_G, LINE_NUM_DEF_OF_G_IN_BAR}));
+    EXPECT_EQ(store.Unit("foo.cpp")->at("g").back().definitions, std::set<unsigned int>{LINE_NUM_DECL_DEF_OF_G});
+    EXPECT_EQ(store.DeclaringUnits("bar.cpp"), std::unordered_set<std::string>{"foo.cpp"});
+
+    store.Replace("bar.cpp", UnitsToSrcML({{"bar.cpp", "void set(){\n\ng = 6;\n}\n"}}));
+    merged = store.Merged("foo.cpp");
+    ASSERT_EQ(merged["g"].size(), 1);
+    EXPECT_EQ(merged["g"].back().definitions, (std::set<unsigned int>{LINE_NUM_DECL_DEF_OF_G, LINE_NUM_DEF_OF_G_IN_NEW_BAR}));
+}
+
+TEST(TestsrcSliceProfileStoreKeys, TestUnitKeysNeverCollide) {
+    std::string srcml = 
+    "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+    "<unit xmlns=\"http://www.srcML.org/srcML/src\" revision=\"1.0.0\">\n"
+    "<unit revision=\"1.0.0\" language=\"C++\" filename=\"dup.cpp\"></unit>\n"
+    "<unit revision=\"1.0.0\" language=\"C++\" filename=\"dup.cpp\"></unit>\n"
+    "<unit revision=\"1.0.0\" language=\"C++\" filename=\"a&amp;b.cpp\"></unit>\n"
+    "<unit revision=\"1.0.0\" language=\"C++\"></unit>\n"
+    "</unit>\n";
+    ProfileStore store;
+    const int NUM_UNITS = 4;
+
+    EXPECT_EQ(store.Load(srcml), NUM_UNITS);
+    EXPECT_EQ(store.NumUnits(), NUM_UNITS);
+    EXPECT_TRUE(store.Unit("dup.cpp") != 0);
+    EXPECT_TRUE(store.Unit("dup.cpp#2") != 0);
+    EXPECT_TRUE(store.Unit("a&b.cpp") != 0);
+    EXPECT_TRUE(store.Unit("<unit 4>") != 0);
+}
+
+TEST(TestXmlUnescape, TestEntitiesAndCharacterReferences) {
+    EXPECT_EQ(XmlUnescape("a&amp;b&lt;c&gt;&quot;d&apos;"), "a&b<c>\"d'");
+    EXPECT_EQ(XmlUnescape("&#65;&#x42;&#xe9;"), "AB\xc3\xa9");
+    EXPECT_EQ(XmlUnescape("R&D; &unknown; &"), "R&D; &unknown; &");
+}